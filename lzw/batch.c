@@ -0,0 +1,187 @@
+#define _POSIX_C_SOURCE 200809L
+#include "batch.h"
+
+#include "common.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Jobs still owned by a worker, begin in the low and end in the high half, so
+// the owner taking from the front and thieves taking from the back agree with
+// a single compare-and-swap.
+#define RANGE(begin, end) ((uint64_t)(end) << 32 | (uint32_t)(begin))
+#define RANGE_BEGIN(range) ((uint32_t)(range))
+#define RANGE_END(range) ((uint32_t)((range) >> 32))
+
+struct batch_worker
+{
+    _Atomic uint64_t range;
+    struct batch *batch;
+    unsigned index;
+    pthread_t thread;
+    bool started;
+};
+
+struct batch
+{
+    struct lzw_job *jobs;
+    lzw_decode_fn decode;
+    struct batch_worker *workers;
+    unsigned worker_count;
+    atomic_size_t failed;
+};
+
+void lzw_job_set_error(struct lzw_job *job)
+{
+    job->error = SUCCESS;
+    if (job->result == (size_t)-1)
+    {
+        size_t decoded_size;
+        int16_t error = lzw_decode_checked(job->in, job->in_size, job->out, job->out_size, &decoded_size);
+        // Only arguments the engines reject up front decode here
+        job->error = error != SUCCESS ? error : INVALID_CODE;
+    }
+}
+
+static bool batch_take(struct batch_worker *worker, uint32_t *job)
+{
+    uint64_t range = atomic_load(&worker->range);
+    while (RANGE_BEGIN(range) < RANGE_END(range))
+    {
+        if (atomic_compare_exchange_weak(&worker->range, &range, RANGE(RANGE_BEGIN(range) + 1, RANGE_END(range))))
+        {
+            *job = RANGE_BEGIN(range);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Moves the back half of the fullest other range into worker's own range.
+static bool batch_steal(struct batch_worker *worker)
+{
+    struct batch *b = worker->batch;
+
+    for (;;)
+    {
+        struct batch_worker *victim = NULL;
+        uint32_t most = 0;
+        for (unsigned i = 1; i < b->worker_count; i++)
+        {
+            struct batch_worker *other = &b->workers[(worker->index + i) % b->worker_count];
+            uint64_t range = atomic_load(&other->range);
+            uint32_t left = RANGE_END(range) - RANGE_BEGIN(range);
+            if (RANGE_BEGIN(range) < RANGE_END(range) && left > most)
+            {
+                victim = other;
+                most = left;
+            }
+        }
+
+        if (victim == NULL)
+        {
+            return false;
+        }
+
+        uint64_t range = atomic_load(&victim->range);
+        uint32_t begin = RANGE_BEGIN(range);
+        uint32_t end = RANGE_END(range);
+        if (begin >= end)
+        {
+            continue;
+        }
+
+        uint32_t middle = begin + (end - begin) / 2;
+        if (atomic_compare_exchange_strong(&victim->range, &range, RANGE(begin, middle)))
+        {
+            atomic_store(&worker->range, RANGE(middle, end));
+            return true;
+        }
+    }
+}
+
+static void *batch_run(void *arg)
+{
+    struct batch_worker *worker = arg;
+    struct batch *b = worker->batch;
+    size_t failed = 0;
+
+    do
+    {
+        uint32_t index;
+        while (batch_take(worker, &index))
+        {
+            struct lzw_job *job = &b->jobs[index];
+            job->result = b->decode(job->in, job->in_size, job->out, job->out_size);
+            lzw_job_set_error(job);
+            failed += job->result == (size_t)-1;
+        }
+    } while (batch_steal(worker));
+
+    atomic_fetch_add(&b->failed, failed);
+    return NULL;
+}
+
+size_t lzw_decode_batch(struct lzw_job *jobs, size_t count, lzw_decode_fn decode, unsigned threads)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    if (jobs == NULL || decode == NULL || count > UINT32_MAX)
+    {
+        return -1;
+    }
+
+    if (threads == 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (unsigned)online : 1;
+    }
+    if (threads > count)
+    {
+        threads = (unsigned)count;
+    }
+
+    struct batch_worker *workers = malloc(threads * sizeof(*workers));
+    if (workers == NULL)
+    {
+        threads = 1;
+    }
+
+    struct batch_worker single;
+    struct batch b = {jobs, decode, workers != NULL ? workers : &single, threads, 0};
+
+    for (unsigned i = 0; i < threads; i++)
+    {
+        b.workers[i].batch = &b;
+        b.workers[i].index = i;
+        atomic_init(&b.workers[i].range, RANGE((uint64_t)count * i / threads, (uint64_t)count * (i + 1) / threads));
+    }
+
+    // The calling thread is worker 0. A worker that fails to start leaves its
+    // range to be stolen by the others.
+    for (unsigned i = 1; i < threads; i++)
+    {
+        b.workers[i].started = pthread_create(&b.workers[i].thread, NULL, batch_run, &b.workers[i]) == 0;
+    }
+
+    batch_run(&b.workers[0]);
+
+    for (unsigned i = 1; i < threads; i++)
+    {
+        if (b.workers[i].started)
+        {
+            pthread_join(b.workers[i].thread, NULL);
+        }
+    }
+
+    free(workers);
+    return atomic_load(&b.failed);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "decode.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// One independently compressed buffer, such as a TIFF strip. result receives
+// the decoded size, or -1 if the strip failed to decode; error receives
+// SUCCESS, or for a failed strip the reason lzw_decode_checked gives for it.
+struct lzw_job
+{
+    const uint8_t *in;
+    size_t in_size;
+    uint8_t *out;
+    size_t out_size;
+    size_t result;
+    int16_t error;
+};
+
+// Sets job->error from job->result, decoding a failed job again with
+// lzw_decode_checked to find out why.
+void lzw_job_set_error(struct lzw_job *job);
+
+// Decodes every job with decode on a pool of threads, 0 meaning one per online
+// CPU. Each worker owns a contiguous range of jobs and steals half of another
+// worker's remaining range once its own is empty. The engines keep their table
+// on the stack, so every worker reuses its own and nothing is allocated per
+// job. Returns the number of failed jobs, or -1 if the arguments are invalid.
+size_t lzw_decode_batch(struct lzw_job *jobs, size_t count, lzw_decode_fn decode, unsigned threads);
@@ -0,0 +1,929 @@
+#define _POSIX_C_SOURCE 200809L
+#include "batch.h"
+#include "code_state.h"
+#include "common.h"
+#include "context.h"
+#include "decode.h"
+#include "dispatch.h"
+#include "encode.h"
+#include "index.h"
+#include "reader.h"
+#include "stats.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#define ITERATIONS 1000
+#define BENCHMARK_ITERATIONS 10
+#define CORPUS_RUNS 5
+#define CORPUS_DEFAULT_MB 16
+
+// Set by the release targets in the Makefile
+#ifndef LZW_BUILD
+#define LZW_BUILD "default"
+#endif
+
+static inline double get_time_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static uint8_t *read_file(const char *path, size_t *size, size_t slack)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    uint8_t *data = malloc((file_size > 0 ? (size_t)file_size : 1) + slack);
+    if (data != NULL && fread(data, 1, (size_t)file_size, f) != (size_t)file_size)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+
+    *size = (size_t)file_size;
+    return data;
+}
+
+// CLEAR_CODE followed by codes_per_clear 9-bit literals, repeated, so the
+// dictionary is reset after every few entries like in small TIFF strips.
+static uint8_t *make_clear_heavy(size_t clears, size_t codes_per_clear, size_t *encoded_size, uint8_t **expected,
+                                 size_t *expected_size)
+{
+    *expected_size = clears * codes_per_clear;
+    *expected = malloc(*expected_size);
+    *encoded_size = ((clears * (codes_per_clear + 1) + 1) * 9 + 7) / 8;
+    uint8_t *encoded = calloc(*encoded_size + LZW_FAST_OUT_SLACK, 1);
+
+    size_t bit = 0;
+    for (size_t i = 0; i <= clears * (codes_per_clear + 1); i++)
+    {
+        uint16_t code;
+        if (i == clears * (codes_per_clear + 1))
+        {
+            code = END_OF_INFORMATION;
+        }
+        else if (i % (codes_per_clear + 1) == 0)
+        {
+            code = CLEAR_CODE;
+        }
+        else
+        {
+            code = (uint8_t)(i * 7);
+            (*expected)[i - i / (codes_per_clear + 1) - 1] = code;
+        }
+
+        for (int b = 8; b >= 0; b--, bit++)
+        {
+            encoded[bit / 8] |= ((code >> b) & 1) << (7 - bit % 8);
+        }
+    }
+
+    return encoded;
+}
+
+#ifdef LZW_STATS
+// One lzw_decode with the counters of an -DLZW_STATS build.
+static void benchmark_stats(const char *label, const uint8_t *encoded, size_t encoded_size, uint8_t *decoded,
+                            size_t size)
+{
+    lzw_stats_reset();
+    lzw_decode(encoded, encoded_size, decoded, size);
+    struct lzw_stats stats = lzw_stats;
+    lzw_stats_print(stdout, label, &stats);
+}
+#endif
+
+void benchmark_buffer(const char *name, lzw_decode_fn decode, const char *label, const uint8_t *encoded,
+                      size_t encoded_size, const uint8_t *expected, size_t expected_size, size_t slack)
+{
+    size_t out_size = expected_size;
+    uint8_t *decoded = malloc(out_size + slack);
+
+    size_t decoded_size = decode(encoded, encoded_size, decoded, out_size);
+    if (decoded_size != expected_size || memcmp(decoded, expected, expected_size) != 0)
+    {
+        printf("%s %s: decoded content does not match expected\n", name, label);
+        free(decoded);
+        return;
+    }
+
+    // Warmup
+    for (int i = 0; i < ITERATIONS / 10; i++)
+    {
+        decode(encoded, encoded_size, decoded, out_size);
+    }
+
+    // Benchmark
+    double total_time = 0;
+    for (int bench = 0; bench < BENCHMARK_ITERATIONS; bench++)
+    {
+        double start = get_time_ms();
+        for (int i = 0; i < ITERATIONS; i++)
+        {
+            decode(encoded, encoded_size, decoded, out_size);
+        }
+        double end = get_time_ms();
+        total_time += (end - start);
+    }
+
+    double avg_time = total_time / BENCHMARK_ITERATIONS;
+    double time_per_call = avg_time / ITERATIONS;
+    double throughput = expected_size / (time_per_call / 1000.0) / (1024.0 * 1024.0);
+
+    printf("%s %-20s: %.3f ms total (%.3f us per decode, %.1f MB/s)\n", name, label, avg_time,
+           time_per_call * 1000.0, throughput);
+
+    free(decoded);
+}
+
+void benchmark(const char *name, lzw_decode_fn decode, const char *encoded_path, const char *expected_path,
+               size_t slack)
+{
+    size_t encoded_size, expected_size;
+    uint8_t *encoded = read_file(encoded_path, &encoded_size, slack);
+    uint8_t *expected = read_file(expected_path, &expected_size, 0);
+    if (encoded == NULL || expected == NULL)
+    {
+        printf("%s %s: failed to read test data\n", name, encoded_path);
+        return;
+    }
+
+    benchmark_buffer(name, decode, encoded_path, encoded, encoded_size, expected, expected_size, slack);
+#ifdef LZW_STATS
+    if (decode == lzw_decode)
+    {
+        uint8_t *decoded = malloc(expected_size);
+        benchmark_stats(encoded_path, encoded, encoded_size, decoded, expected_size);
+        free(decoded);
+    }
+#endif
+
+    free(encoded);
+    free(expected);
+}
+
+void benchmark_clear_heavy(const char *name, lzw_decode_fn decode, size_t codes_per_clear, size_t slack)
+{
+    size_t encoded_size, expected_size;
+    uint8_t *expected;
+    uint8_t *encoded = make_clear_heavy(4096 / codes_per_clear, codes_per_clear, &encoded_size, &expected,
+                                        &expected_size);
+
+    char label[32];
+    snprintf(label, sizeof(label), "clear every %zu", codes_per_clear);
+    benchmark_buffer(name, decode, label, encoded, encoded_size, expected, expected_size, slack);
+
+    free(encoded);
+    free(expected);
+}
+
+void benchmark_encode(const char *path)
+{
+    size_t size;
+    uint8_t *data = read_file(path, &size, 0);
+    size_t out_size = LZW_ENCODE_BOUND(size);
+    uint8_t *encoded = malloc(out_size);
+    uint8_t *decoded = malloc(size + 1);
+    if (data == NULL || encoded == NULL || decoded == NULL)
+    {
+        printf("lzw_encode %s: failed to read test data\n", path);
+        return;
+    }
+
+    size_t encoded_size = lzw_encode(data, size, encoded, out_size);
+    if (encoded_size == (size_t)-1 || lzw_decode(encoded, encoded_size, decoded, size + 1) != size ||
+        memcmp(decoded, data, size) != 0)
+    {
+        printf("lzw_encode %s: round trip does not match\n", path);
+        return;
+    }
+
+    // Warmup
+    for (int i = 0; i < ITERATIONS / 10; i++)
+    {
+        lzw_encode(data, size, encoded, out_size);
+    }
+
+    // Benchmark
+    double total_time = 0;
+    for (int bench = 0; bench < BENCHMARK_ITERATIONS; bench++)
+    {
+        double start = get_time_ms();
+        for (int i = 0; i < ITERATIONS; i++)
+        {
+            lzw_encode(data, size, encoded, out_size);
+        }
+        double end = get_time_ms();
+        total_time += (end - start);
+    }
+
+    double avg_time = total_time / BENCHMARK_ITERATIONS;
+    double time_per_call = avg_time / ITERATIONS;
+    double throughput = size / (time_per_call / 1000.0) / (1024.0 * 1024.0);
+
+    printf("lzw_encode      %-20s: %.3f ms total (%.3f us per encode, %.1f MB/s)\n", path, avg_time,
+           time_per_call * 1000.0, throughput);
+
+    free(data);
+    free(encoded);
+    free(decoded);
+}
+
+// 1000 independently encoded 8 KB strips, like a large striped TIFF.
+void benchmark_batch(const char *name, lzw_decode_fn decode)
+{
+    size_t count = 1000;
+    size_t strip_size = 8192;
+    size_t bound = LZW_ENCODE_BOUND(strip_size);
+    uint8_t *raw = malloc(strip_size);
+    uint8_t *encoded = malloc(count * bound);
+    uint8_t *decoded = malloc(count * strip_size);
+    struct lzw_job *jobs = malloc(count * sizeof(*jobs));
+
+    srand(1);
+    for (size_t i = 0; i < count; i++)
+    {
+        for (size_t j = 0; j < strip_size; j++)
+        {
+            raw[j] = (uint8_t)(j / 64 + i) ^ (uint8_t)(rand() % 4);
+        }
+        jobs[i].in = encoded + i * bound;
+        jobs[i].in_size = lzw_encode(raw, strip_size, encoded + i * bound, bound);
+        jobs[i].out = decoded + i * strip_size;
+        jobs[i].out_size = strip_size;
+    }
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned thread_counts[] = {1, 2, 4, online > 0 ? (unsigned)online : 1};
+    double single = 0;
+
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++)
+    {
+        unsigned threads = thread_counts[t];
+
+        // Warmup
+        lzw_decode_batch(jobs, count, decode, threads);
+
+        double total_time = 0;
+        size_t failed = 0;
+        for (int bench = 0; bench < BENCHMARK_ITERATIONS; bench++)
+        {
+            double start = get_time_ms();
+            failed += lzw_decode_batch(jobs, count, decode, threads);
+            double end = get_time_ms();
+            total_time += (end - start);
+        }
+
+        double avg_time = total_time / BENCHMARK_ITERATIONS;
+        double throughput = count * strip_size / (avg_time / 1000.0) / (1024.0 * 1024.0);
+        if (t == 0)
+        {
+            single = avg_time;
+        }
+
+        printf("%s batch %4zu strips %2u threads: %.3f ms (%.1f MB/s, %.2fx)%s\n", name, count, threads, avg_time,
+               throughput, single / avg_time, failed != 0 ? " FAILED" : "");
+    }
+
+    free(raw);
+    free(encoded);
+    free(decoded);
+    free(jobs);
+}
+
+// Predictor=2 image decoded twice: lzw_decode_context, the engine under
+// lzw_decode_predictor, followed by a second pass over the rows, and
+// lzw_decode_predictor undoing the rows of each table generation.
+void benchmark_predictor(size_t width, size_t height, uint8_t bytes_per_sample, uint8_t samples_per_pixel)
+{
+    struct lzw_predictor p = {width * bytes_per_sample * samples_per_pixel, bytes_per_sample, samples_per_pixel,
+                              false};
+    size_t size = p.row_size * height;
+    uint8_t *image = malloc(size);
+    uint8_t *encoded = malloc(LZW_ENCODE_BOUND(size));
+    uint8_t *decoded = malloc(size);
+
+    // Smooth gradient with noise, differenced per row from the back
+    srand(1);
+    for (size_t i = 0; i < size; i++)
+    {
+        image[i] = (uint8_t)((i % p.row_size) / 16 + i / p.row_size + rand() % 3);
+    }
+    size_t stride = (size_t)bytes_per_sample * samples_per_pixel;
+    for (size_t row = 0; row < size; row += p.row_size)
+    {
+        for (size_t i = p.row_size - 1; i >= stride; i--)
+        {
+            image[row + i] -= image[row + i - stride];
+        }
+    }
+    size_t encoded_size = lzw_encode(image, size, encoded, LZW_ENCODE_BOUND(size));
+
+    char label[48];
+    snprintf(label, sizeof(label), "%zux%zu %ux%u-bit", width, height, samples_per_pixel, bytes_per_sample * 8);
+
+    static struct lzw_context ctx;
+    double two_pass = 0, fused = 0;
+    for (int bench = 0; bench < BENCHMARK_ITERATIONS; bench++)
+    {
+        double start = get_time_ms();
+        for (int i = 0; i < ITERATIONS / 10; i++)
+        {
+            lzw_decode_context(&ctx, encoded, encoded_size, decoded, size);
+            for (size_t row = 0; row < size; row += p.row_size)
+            {
+                predictor_undo(decoded + row, p.row_size, &p);
+            }
+        }
+        double middle = get_time_ms();
+        for (int i = 0; i < ITERATIONS / 10; i++)
+        {
+            lzw_decode_predictor(encoded, encoded_size, decoded, size, &p);
+        }
+        double end = get_time_ms();
+        two_pass += middle - start;
+        fused += end - middle;
+    }
+
+    double calls = (double)BENCHMARK_ITERATIONS * (ITERATIONS / 10);
+    printf("predictor %-22s: two passes %.1f MB/s, fused %.1f MB/s\n", label,
+           size / (two_pass / calls / 1000.0) / (1024.0 * 1024.0), size / (fused / calls / 1000.0) / (1024.0 * 1024.0));
+
+    free(image);
+    free(encoded);
+    free(decoded);
+}
+
+// Reported in MB/s of the output it sizes, to compare with the decoders.
+void benchmark_decoded_size(const char *encoded_path)
+{
+    size_t encoded_size;
+    uint8_t *encoded = read_file(encoded_path, &encoded_size, 0);
+    if (encoded == NULL)
+    {
+        printf("lzw_decoded_size %s: failed to read test data\n", encoded_path);
+        return;
+    }
+
+    size_t size = lzw_decoded_size(encoded, encoded_size);
+    if (size == (size_t)-1)
+    {
+        printf("lzw_decoded_size %s: invalid stream\n", encoded_path);
+        free(encoded);
+        return;
+    }
+
+    // Warmup
+    for (int i = 0; i < ITERATIONS / 10; i++)
+    {
+        lzw_decoded_size(encoded, encoded_size);
+    }
+
+    // Benchmark
+    double total_time = 0;
+    for (int bench = 0; bench < BENCHMARK_ITERATIONS; bench++)
+    {
+        double start = get_time_ms();
+        for (int i = 0; i < ITERATIONS; i++)
+        {
+            lzw_decoded_size(encoded, encoded_size);
+        }
+        double end = get_time_ms();
+        total_time += (end - start);
+    }
+
+    double avg_time = total_time / BENCHMARK_ITERATIONS;
+    double time_per_call = avg_time / ITERATIONS;
+    double throughput = size / (time_per_call / 1000.0) / (1024.0 * 1024.0);
+
+    printf("lzw_decoded_size %-20s: %.3f ms total (%.3f us per call, %.1f MB/s)\n", encoded_path, avg_time,
+           time_per_call * 1000.0, throughput);
+
+    free(encoded);
+}
+
+// 4 KB reads from random offsets of a stream of size bytes, served by
+// lzw_decode_range against decoding everything up to the end of the read.
+void benchmark_range(size_t size)
+{
+    uint8_t *data = malloc(size);
+    size_t encoded_size = LZW_ENCODE_BOUND(size);
+    uint8_t *encoded = malloc(encoded_size);
+    uint8_t *decoded = malloc(size);
+    uint8_t range[4096];
+
+    srand(16);
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = (uint8_t)(rand() % 5);
+    }
+    encoded_size = lzw_encode(data, size, encoded, encoded_size);
+
+    struct lzw_index index;
+    double start = get_time_ms();
+    if (lzw_index_build(&index, encoded, encoded_size) != SUCCESS)
+    {
+        printf("range: index build failed\n");
+        free(data);
+        free(encoded);
+        free(decoded);
+        return;
+    }
+    double build_time = get_time_ms() - start;
+
+    size_t reads = ITERATIONS;
+    uint64_t *offsets = malloc(reads * sizeof(*offsets));
+    for (size_t i = 0; i < reads; i++)
+    {
+        offsets[i] = (uint64_t)rand() * (size - sizeof(range)) / RAND_MAX;
+    }
+
+    start = get_time_ms();
+    for (size_t i = 0; i < reads; i++)
+    {
+        if (lzw_decode_range(encoded, encoded_size, &index, offsets[i], range, sizeof(range)) != sizeof(range) ||
+            memcmp(range, data + offsets[i], sizeof(range)) != 0)
+        {
+            printf("range: decoded content does not match expected\n");
+            break;
+        }
+    }
+    double range_time = get_time_ms() - start;
+
+    // Without an index: lzw_decode_copy stops with -1 once the output up to the
+    // end of the read is full.
+    start = get_time_ms();
+    for (size_t i = 0; i < reads / 10; i++)
+    {
+        lzw_decode_copy(encoded, encoded_size, decoded, offsets[i] + sizeof(range));
+    }
+    double prefix_time = (get_time_ms() - start) * 10;
+
+    printf("range %zu KB, %zu checkpoints: index build %.3f ms, 4 KB read %.1f us with index, %.1f us decoding the "
+           "prefix\n",
+           size / 1024, index.count, build_time, range_time * 1000.0 / reads, prefix_time * 1000.0 / reads);
+
+    lzw_index_free(&index);
+    free(offsets);
+    free(data);
+    free(encoded);
+    free(decoded);
+}
+
+// 10000 copies of one small buffer, decoded one call per buffer and as one
+// lzw_decode_jobs list; reported in ns per buffer.
+void benchmark_small(const char *encoded_path, const char *expected_path)
+{
+    size_t encoded_size, expected_size;
+    uint8_t *encoded = read_file(encoded_path, &encoded_size, 0);
+    uint8_t *expected = read_file(expected_path, &expected_size, 0);
+    if (encoded == NULL || expected == NULL)
+    {
+        printf("small %s: failed to read test data\n", encoded_path);
+        return;
+    }
+
+    size_t count = 10000;
+    uint8_t *out = malloc(count * expected_size);
+    struct lzw_job *jobs = malloc(count * sizeof(*jobs));
+    static struct lzw_context ctx;
+    for (size_t i = 0; i < count; i++)
+    {
+        jobs[i] = (struct lzw_job){encoded, encoded_size, out + i * expected_size, expected_size, 0, SUCCESS};
+    }
+
+    lzw_decode_fn engines[] = {lzw_decode, lzw_decode_copy};
+    const char *names[] = {"lzw_decode     ", "lzw_decode_copy"};
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++)
+    {
+        double best = 0;
+        for (int bench = 0; bench < BENCHMARK_ITERATIONS; bench++)
+        {
+            double start = get_time_ms();
+            for (size_t i = 0; i < count; i++)
+            {
+                jobs[i].result = engines[e](jobs[i].in, jobs[i].in_size, jobs[i].out, jobs[i].out_size);
+            }
+            double time = get_time_ms() - start;
+            best = bench == 0 || time < best ? time : best;
+        }
+        printf("small %s %-20s: %.1f ns per buffer\n", names[e], encoded_path, best * 1e6 / count);
+    }
+
+    double best = 0;
+    size_t failed = 0;
+    for (int bench = 0; bench < BENCHMARK_ITERATIONS; bench++)
+    {
+        double start = get_time_ms();
+        failed += lzw_decode_jobs(&ctx, jobs, count);
+        double time = get_time_ms() - start;
+        best = bench == 0 || time < best ? time : best;
+    }
+    if (failed != 0 || memcmp(jobs[count - 1].out, expected, expected_size) != 0)
+    {
+        printf("small lzw_decode_jobs %s: decoded content does not match expected\n", encoded_path);
+    }
+    printf("small lzw_decode_jobs   %-20s: %.1f ns per buffer\n", encoded_path, best * 1e6 / count);
+
+    free(jobs);
+    free(out);
+    free(encoded);
+    free(expected);
+}
+
+void benchmark_reader(const char *encoded_path, uint8_t bits_count)
+{
+    size_t encoded_size;
+    uint8_t *encoded = read_file(encoded_path, &encoded_size, 0);
+    if (encoded == NULL)
+    {
+        printf("reader %s: failed to read test data\n", encoded_path);
+        return;
+    }
+
+    struct reader r;
+    uint32_t checksum = 0;
+    size_t codes = 0;
+
+    // Warmup
+    for (int i = 0; i < ITERATIONS / 10; i++)
+    {
+        reader_init(&r, encoded, encoded_size);
+        while (reader_has_next(&r, bits_count))
+        {
+            checksum += reader_next(&r, bits_count);
+        }
+    }
+
+    // Benchmark
+    double total_time = 0;
+    for (int bench = 0; bench < BENCHMARK_ITERATIONS; bench++)
+    {
+        double start = get_time_ms();
+        for (int i = 0; i < ITERATIONS; i++)
+        {
+            reader_init(&r, encoded, encoded_size);
+            while (reader_has_next(&r, bits_count))
+            {
+                checksum += reader_next(&r, bits_count);
+                codes++;
+            }
+        }
+        double end = get_time_ms();
+        total_time += (end - start);
+    }
+
+    double codes_per_second = codes / (total_time / 1000.0);
+
+    printf("reader %-20s: %u-bit codes, %.1f M codes/s (checksum %u)\n", encoded_path, bits_count,
+           codes_per_second / 1e6, checksum);
+
+    free(encoded);
+}
+
+// Generated corpora, from nothing to learn to nothing to compress.
+
+static void corpus_aaa(uint8_t *data, size_t size)
+{
+    memset(data, 'a', size);
+}
+
+// Words drawn from a small vocabulary with Zipf-like frequencies, so there is
+// structure to learn but the table keeps filling.
+static void corpus_text(uint8_t *data, size_t size)
+{
+    static const char *words[] = {"the",   "of",     "and",     "to",      "a",         "in",     "is",
+                                  "that",  "for",    "it",      "as",      "with",      "was",    "on",
+                                  "be",    "by",     "this",    "are",     "from",      "or",     "table",
+                                  "code",  "string", "decoder", "stream",  "compress",  "width",  "prefix",
+                                  "entry", "output", "input",   "clear",   "dictionary", "buffer", "literal"};
+    size_t word_count = sizeof(words) / sizeof(words[0]);
+
+    size_t i = 0;
+    while (i < size)
+    {
+        unsigned r = (unsigned)rand();
+        const char *word = words[(r % word_count) * (r / 7 % word_count) / word_count];
+        for (const char *c = word; *c != '\0' && i < size; c++)
+        {
+            data[i++] = (uint8_t)*c;
+        }
+        if (i < size)
+        {
+            data[i++] = r % 13 == 0 ? '\n' : ' ';
+        }
+    }
+}
+
+// 8-bit grayscale rows of a diagonal gradient with a little sensor noise.
+static void corpus_gradient(uint8_t *data, size_t size)
+{
+    size_t width = 2048;
+    for (size_t i = 0; i < size; i++)
+    {
+        size_t x = i % width;
+        size_t y = i / width;
+        data[i] = (uint8_t)((x + y) / 16 + rand() % 3);
+    }
+}
+
+// Scanned-page rows: a flat background with a short noisy mark every 64 bytes,
+// so the same long background codes keep coming back.
+static void corpus_background(uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = i % 64 < 56 ? 0xF0 : (uint8_t)rand();
+    }
+}
+
+static void corpus_random(uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = (uint8_t)rand();
+    }
+}
+
+// Codes in an encoded stream: the width only depends on how many codes
+// followed the last CLEAR_CODE.
+static size_t corpus_count_codes(const uint8_t *encoded, size_t encoded_size)
+{
+    struct reader r;
+    reader_init(&r, encoded, encoded_size);
+
+    size_t codes = 0;
+    struct code_state state;
+    code_state_clear(&state);
+    while (reader_has_next(&r, state.bits_count))
+    {
+        uint16_t code = reader_next(&r, state.bits_count);
+        codes++;
+        if (code == CLEAR_CODE)
+        {
+            code_state_clear(&state);
+            continue;
+        }
+        if (code == END_OF_INFORMATION)
+        {
+            break;
+        }
+        code_state_advance(&state);
+    }
+    return codes;
+}
+
+static struct lzw_context corpus_context;
+
+static size_t corpus_decode_context(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+{
+    return lzw_decode_context(&corpus_context, in, in_size, out, out_size);
+}
+
+// The only corpus engine that walks struct decode_table, so the one
+// bench-table compares the layouts on.
+static size_t corpus_decode_checked(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+{
+    size_t decoded_size;
+    return lzw_decode_checked(in, in_size, out, out_size, &decoded_size) == SUCCESS ? decoded_size : (size_t)-1;
+}
+
+// One warmup run, then CORPUS_RUNS timed ones; prints the best run and the mean.
+static void corpus_report(const char *name, const char *corpus, size_t size, size_t codes, double *times,
+                          uint64_t *cycles)
+{
+    double best = times[0], total = 0;
+    uint64_t best_cycles = cycles[0];
+    for (int run = 0; run < CORPUS_RUNS; run++)
+    {
+        total += times[run];
+        best = times[run] < best ? times[run] : best;
+        best_cycles = cycles[run] < best_cycles ? cycles[run] : best_cycles;
+    }
+
+    double mb = size / (1024.0 * 1024.0);
+    printf("%s %-10s: %7.1f MB/s (mean %7.1f), %6.1f M codes/s, %5.2f cycles/byte\n", name, corpus,
+           mb / (best / 1000.0), mb / (total / CORPUS_RUNS / 1000.0), codes / (best / 1000.0) / 1e6,
+           (double)best_cycles / size);
+}
+
+static void benchmark_corpus(const char *corpus, void (*generate)(uint8_t *data, size_t size), size_t size)
+{
+    size_t encoded_size = LZW_ENCODE_BOUND(size);
+    uint8_t *data = malloc(size);
+    uint8_t *encoded = malloc(encoded_size + LZW_FAST_IN_SLACK);
+    uint8_t *decoded = malloc(size + LZW_FAST_OUT_SLACK);
+    if (data == NULL || encoded == NULL || decoded == NULL)
+    {
+        printf("corpus %s: memory allocation failed\n", corpus);
+        free(data);
+        free(encoded);
+        free(decoded);
+        return;
+    }
+
+    srand(18);
+    generate(data, size);
+
+    double times[CORPUS_RUNS];
+    uint64_t cycles[CORPUS_RUNS];
+    for (int run = -1; run < CORPUS_RUNS; run++)
+    {
+        double start = get_time_ms();
+        uint64_t start_cycles = __rdtsc();
+        encoded_size = lzw_encode(data, size, encoded, LZW_ENCODE_BOUND(size));
+        if (run >= 0)
+        {
+            cycles[run] = __rdtsc() - start_cycles;
+            times[run] = get_time_ms() - start;
+        }
+    }
+    size_t codes = corpus_count_codes(encoded, encoded_size);
+    printf("corpus %-10s: %zu MB, ratio %.3f, %zu codes\n", corpus, size >> 20, (double)encoded_size / size, codes);
+    corpus_report("lzw_encode      ", corpus, size, codes, times, cycles);
+
+    lzw_decode_fn engines[] = {
+        lzw_decode,
+        lzw_decode_copy,
+        corpus_decode_context,
+        corpus_decode_checked,
+#ifdef LZW_FAST
+        lzw_decode_fast,
+#endif
+    };
+    const char *names[] = {
+        "lzw_decode      ",
+        "lzw_decode_copy ",
+        "lzw_decode_ctx  ",
+        "lzw_decode_chk  ",
+#ifdef LZW_FAST
+        "lzw_decode_fast ",
+#endif
+    };
+
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++)
+    {
+        bool ok = true;
+        for (int run = -1; run < CORPUS_RUNS && ok; run++)
+        {
+            double start = get_time_ms();
+            uint64_t start_cycles = __rdtsc();
+            size_t decoded_size = engines[e](encoded, encoded_size, decoded, size);
+            if (run >= 0)
+            {
+                cycles[run] = __rdtsc() - start_cycles;
+                times[run] = get_time_ms() - start;
+            }
+            else
+            {
+                ok = decoded_size == size && memcmp(decoded, data, size) == 0;
+            }
+        }
+
+        if (!ok)
+        {
+            printf("%s %-10s: decoded content does not match expected\n", names[e], corpus);
+            continue;
+        }
+        corpus_report(names[e], corpus, size, codes, times, cycles);
+    }
+#ifdef LZW_STATS
+    benchmark_stats(corpus, encoded, encoded_size, decoded, size);
+#endif
+    printf("\n");
+
+    free(data);
+    free(encoded);
+    free(decoded);
+}
+
+// lzw_decode_auto with every kernel the CPU supports.
+static void benchmark_kernels(const char *encoded_path, const char *expected_path)
+{
+    enum lzw_kernel selected = lzw_kernel_selected();
+    for (int kernel = 0; kernel < LZW_KERNEL_COUNT; kernel++)
+    {
+        if (lzw_kernel_select(kernel))
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "auto %-10s", lzw_kernel_name(kernel));
+            benchmark(name, lzw_decode_auto, encoded_path, expected_path, 0);
+        }
+    }
+    lzw_kernel_select(selected);
+}
+
+static void benchmark_corpora(size_t size)
+{
+    printf("build: %s\n", LZW_BUILD);
+    printf("lzw_decode_auto kernel: %s\n", lzw_kernel_name(lzw_kernel_selected()));
+#ifdef LZW_SOA_TABLE
+    printf("decode_table layout: soa\n\n");
+#else
+    printf("decode_table layout: packed\n\n");
+#endif
+    benchmark_corpus("aaa", corpus_aaa, size);
+    benchmark_corpus("text", corpus_text, size);
+    benchmark_corpus("gradient", corpus_gradient, size);
+    benchmark_corpus("background", corpus_background, size);
+    benchmark_corpus("random", corpus_random, size);
+}
+
+// With an argument only the generated corpora run, at that many MB each.
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+    {
+        long mb = strtol(argv[1], NULL, 10);
+        if (mb <= 0 || (unsigned long)mb > SIZE_MAX / 2 / (1 << 20))
+        {
+            printf("usage: %s [corpus size in MB]\n", argv[0]);
+            return 1;
+        }
+        benchmark_corpora((size_t)mb << 20);
+        return 0;
+    }
+
+    printf("LZW decode benchmark (%d iterations per test, %d runs averaged)\n\n", ITERATIONS, BENCHMARK_ITERATIONS);
+
+    benchmark("lzw_decode     ", lzw_decode, "test_data/in", "test_data/out", 0);
+    benchmark("lzw_decode_copy", lzw_decode_copy, "test_data/in", "test_data/out", 0);
+#ifdef LZW_FAST
+    benchmark("lzw_decode_fast", lzw_decode_fast, "test_data/in", "test_data/out", LZW_FAST_OUT_SLACK);
+#endif
+    printf("\n");
+
+    benchmark("lzw_decode     ", lzw_decode, "test_data/1000.enc", "test_data/1000.dec", 0);
+    benchmark("lzw_decode_copy", lzw_decode_copy, "test_data/1000.enc", "test_data/1000.dec", 0);
+#ifdef LZW_FAST
+    benchmark("lzw_decode_fast", lzw_decode_fast, "test_data/1000.enc", "test_data/1000.dec", LZW_FAST_OUT_SLACK);
+#endif
+    printf("\n");
+
+    benchmark("lzw_decode     ", lzw_decode, "test_data/100_1.enc", "test_data/100_1.dec", 0);
+    benchmark("lzw_decode_copy", lzw_decode_copy, "test_data/100_1.enc", "test_data/100_1.dec", 0);
+#ifdef LZW_FAST
+    benchmark("lzw_decode_fast", lzw_decode_fast, "test_data/100_1.enc", "test_data/100_1.dec", LZW_FAST_OUT_SLACK);
+#endif
+
+    printf("\n");
+
+    benchmark_kernels("test_data/in", "test_data/out");
+    benchmark_kernels("test_data/1000.enc", "test_data/1000.dec");
+    printf("\n");
+
+    benchmark_clear_heavy("lzw_decode     ", lzw_decode, 16, 0);
+    benchmark_clear_heavy("lzw_decode_copy", lzw_decode_copy, 16, 0);
+#ifdef LZW_FAST
+    benchmark_clear_heavy("lzw_decode_fast", lzw_decode_fast, 16, LZW_FAST_OUT_SLACK);
+#endif
+    printf("\n");
+
+    benchmark_batch("lzw_decode     ", lzw_decode);
+    benchmark_batch("lzw_decode_copy", lzw_decode_copy);
+    printf("\n");
+
+    benchmark_predictor(2048, 256, 1, 1);
+    benchmark_predictor(1024, 128, 2, 3);
+    printf("\n");
+
+    benchmark_encode("test_data/out");
+    benchmark_encode("test_data/1000.dec");
+    printf("\n");
+
+    benchmark_decoded_size("test_data/in");
+    benchmark_decoded_size("test_data/1000.enc");
+    printf("\n");
+
+    benchmark_small("test_data/10_1.enc", "test_data/10_1.dec");
+    benchmark_small("test_data/100_1.enc", "test_data/100_1.dec");
+    benchmark_small("test_data/1000.enc", "test_data/1000.dec");
+    printf("\n");
+
+    benchmark_range(1 << 20);
+    benchmark_range(16 << 20);
+    printf("\n");
+
+    benchmark_reader("test_data/in", 9);
+    benchmark_reader("test_data/in", 12);
+    printf("\n");
+
+    benchmark_corpora(CORPUS_DEFAULT_MB << 20);
+
+    return 0;
+}
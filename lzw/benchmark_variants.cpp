@@ -0,0 +1,71 @@
+#include "lzw.hpp"
+#include "read_file.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#define ITERATIONS 100
+#define BENCHMARK_ITERATIONS 10
+
+using decode_fn = size_t (*)(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size);
+
+static void benchmark(const char *name, decode_fn decode, const char *encoded_path, const char *expected_path)
+{
+    std::vector<uint8_t> encoded = read_file(encoded_path);
+    std::vector<uint8_t> expected = read_file(expected_path);
+    if (encoded.empty() || expected.empty())
+    {
+        printf("%-16s %-26s: failed to read test data\n", name, encoded_path);
+        return;
+    }
+
+    std::vector<uint8_t> decoded(expected.size());
+    size_t decoded_size = decode(encoded.data(), encoded.size(), decoded.data(), decoded.size());
+    if (decoded_size != expected.size() || decoded != expected)
+    {
+        printf("%-16s %-26s: decoded content does not match expected\n", name, encoded_path);
+        return;
+    }
+
+    // Warmup
+    for (int i = 0; i < ITERATIONS / 10; i++)
+    {
+        decode(encoded.data(), encoded.size(), decoded.data(), decoded.size());
+    }
+
+    // Benchmark
+    double total_time = 0;
+    for (int bench = 0; bench < BENCHMARK_ITERATIONS; bench++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; i++)
+        {
+            decode(encoded.data(), encoded.size(), decoded.data(), decoded.size());
+        }
+        auto end = std::chrono::steady_clock::now();
+        total_time += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    double avg_time = total_time / BENCHMARK_ITERATIONS;
+    double time_per_call = avg_time / ITERATIONS;
+    double throughput = expected.size() / (time_per_call / 1000.0) / (1024.0 * 1024.0);
+
+    printf("%-16s %-26s: %.3f ms total (%.3f us per decode, %.1f MB/s)\n", name, encoded_path, avg_time,
+           time_per_call * 1000.0, throughput);
+}
+
+int main()
+{
+    benchmark("tiff", lzw::decode<lzw::tiff>, "test_data/in", "test_data/out");
+    benchmark("tiff", lzw::decode<lzw::tiff>, "test_data/1000.enc", "test_data/1000.dec");
+    benchmark("pdf<0>", lzw::decode<lzw::pdf<0>>, "test_data/out_early0.pdf", "test_data/out");
+    benchmark("gif<2>", lzw::decode<lzw::gif<2>>, "test_data/gif_2.enc", "test_data/gif_2.dec");
+    benchmark("gif<8>", lzw::decode<lzw::gif<8>>, "test_data/out.gif", "test_data/out");
+    benchmark("gif<8> deferred", lzw::decode<lzw::gif<8>>, "test_data/out_deferred.gif", "test_data/out");
+    benchmark("compress<16>", lzw::decode_compress, "test_data/out.Z", "test_data/out");
+    benchmark("compress<12>", lzw::decode_compress, "test_data/out_12.Z", "test_data/out");
+    benchmark("compress<12> nb", lzw::decode_compress, "test_data/out_nonblock.Z", "test_data/out");
+    return 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// The refill of reader.c as static inline functions on a local struct, so the
+// compiler keeps the state in registers. For loops that do so little per code
+// that calling into the reader would dominate them.
+struct bit_buffer
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    uint64_t bits;
+    uint32_t available;
+};
+
+static inline void bit_buffer_init(struct bit_buffer *b, const uint8_t *data, size_t size)
+{
+    b->p = data;
+    b->end = data + size;
+    b->bits = 0;
+    b->available = 0;
+}
+
+// Makes count bits available; false once the input runs out.
+static inline bool bit_buffer_fill(struct bit_buffer *b, uint32_t count)
+{
+    if (b->available >= count)
+    {
+        return true;
+    }
+
+    if (b->end - b->p >= 8)
+    {
+        uint64_t data;
+        memcpy(&data, b->p, sizeof(data));
+        b->bits |= __builtin_bswap64(data) >> b->available;
+        b->p += (63 - b->available) >> 3;
+        b->available |= 56;
+        return true;
+    }
+
+    while (b->available <= 56 && b->p < b->end)
+    {
+        b->bits |= (uint64_t)*b->p++ << (56 - b->available);
+        b->available += 8;
+    }
+    return b->available >= count;
+}
+
+static inline uint32_t bit_buffer_take(struct bit_buffer *b, uint32_t count)
+{
+    uint32_t value = b->bits >> (64 - count);
+    b->bits <<= count;
+    b->available -= count;
+    return value;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "common.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The per-code state machine every decoder shares: what a code means for the
+// current dictionary size, and how the dictionary and the code width move on
+// once its string is out. What the dictionary holds is up to the caller.
+struct code_state
+{
+    uint32_t next_code;
+    uint32_t bits_count;
+    uint32_t widen_code; // next_code that widens codes
+    bool after_clear;    // no previous string to extend yet
+};
+
+enum code_kind
+{
+    CODE_LITERAL,
+    CODE_STRING, // a dictionary entry past the literals
+    CODE_KWKWK,  // the entry being added: the previous string plus its first byte
+    CODE_CLEAR,
+    CODE_END,
+    CODE_INVALID,
+};
+
+static inline void code_state_clear(struct code_state *s)
+{
+    s->next_code = FIRST_CODE;
+    s->bits_count = 9;
+    s->widen_code = (1u << 9) - 1;
+    s->after_clear = true;
+}
+
+static inline enum code_kind code_state_classify(const struct code_state *s, uint32_t code)
+{
+    if (code < CLEAR_CODE)
+    {
+        return CODE_LITERAL;
+    }
+    if (code == CLEAR_CODE)
+    {
+        return CODE_CLEAR;
+    }
+    if (code == END_OF_INFORMATION)
+    {
+        return CODE_END;
+    }
+    if (code < s->next_code)
+    {
+        return CODE_STRING;
+    }
+    if (code == s->next_code && !s->after_clear)
+    {
+        return CODE_KWKWK;
+    }
+    return CODE_INVALID;
+}
+
+// Called once the string of a code is out. Returns the entry it adds, the
+// previous string plus the first byte of this one, for the caller to fill in,
+// or 0 if it adds none: right after CLEAR, and while the table is full.
+static inline uint32_t code_state_advance(struct code_state *s)
+{
+    if (s->after_clear)
+    {
+        s->after_clear = false;
+        return 0;
+    }
+    if (s->next_code == MAX_CODE)
+    {
+        return 0;
+    }
+
+    uint32_t entry = s->next_code++;
+    if (s->next_code == s->widen_code && s->bits_count < MAX_BITS_COUNT)
+    {
+        s->bits_count++;
+        s->widen_code = (1u << s->bits_count) - 1;
+    }
+    return entry;
+}
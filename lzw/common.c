@@ -22,6 +22,15 @@ char const *error_message(int16_t error_code)
     case DECODE_TABLE_INVARIANT_VIOLATION: {
         return "Table invariant violation";
     }
+    case INVALID_TIFF: {
+        return "Invalid TIFF file";
+    }
+    case INVALID_INDEX: {
+        return "Invalid LZW index";
+    }
+    case OUTPUT_OVERFLOW: {
+        return "Output buffer too small";
+    }
     }
     return "Unknown error";
 }
@@ -15,6 +15,9 @@
 #define INVALID_CODE -1
 #define TABLE_OVERFLOW -2
 #define DECODE_TABLE_INVARIANT_VIOLATION -3
+#define INVALID_TIFF -4
+#define INVALID_INDEX -5
+#define OUTPUT_OVERFLOW -6
 
 bool error(int16_t code);
 
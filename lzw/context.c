@@ -0,0 +1,46 @@
+#include "context.h"
+
+#include "batch.h"
+#include "common.h"
+#include "context_kernel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+size_t lzw_decode_context(struct lzw_context *ctx, const uint8_t *in, size_t in_size, uint8_t *restrict out,
+                          size_t out_size)
+{
+    if (ctx == NULL || in == NULL || (out == NULL && out_size != 0))
+    {
+        return -1;
+    }
+
+    return context_decode(ctx, in, in_size, out, out_size, false, NULL);
+}
+
+size_t lzw_decode_jobs(struct lzw_context *ctx, struct lzw_job *jobs, size_t count)
+{
+    if (ctx == NULL || (jobs == NULL && count != 0))
+    {
+        return -1;
+    }
+
+    size_t failed = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        struct lzw_job *job = &jobs[i];
+        if (job->in == NULL || (job->out == NULL && job->out_size != 0))
+        {
+            job->result = -1;
+        }
+        else
+        {
+            job->result = context_decode(ctx, job->in, job->in_size, job->out, job->out_size, false, NULL);
+        }
+        lzw_job_set_error(job);
+        failed += job->result == (size_t)-1;
+    }
+
+    return failed;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "batch.h"
+#include "common.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Dictionary of lzw_decode_copy kept between calls. Entries below next_code
+// are always written before they are read, so nothing needs initializing and
+// starting a buffer only resets the code width and next_code.
+struct lzw_context
+{
+    uint32_t offsets[MAX_CODE];
+    uint16_t lengths[MAX_CODE];
+};
+
+// lzw_decode_copy with the dictionary in ctx and the bit reader inlined.
+size_t lzw_decode_context(struct lzw_context *ctx, const uint8_t *in, size_t in_size, uint8_t *restrict out,
+                          size_t out_size);
+
+// Decodes jobs back to back on the calling thread with one context, for many
+// buffers of tens or hundreds of bytes where per-call setup dominates. Sets
+// every result and error like lzw_decode_batch and returns the number of
+// failed jobs, or -1 if the arguments are invalid.
+size_t lzw_decode_jobs(struct lzw_context *ctx, struct lzw_job *jobs, size_t count);
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "bit_buffer.h"
+#include "code_state.h"
+#include "common.h"
+#include "context.h"
+#include "predictor.h"
+#include "stats.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Copies a dictionary string. With chunked set, strings of 8 to 32 bytes are
+// copied inline as two blocks of 16 or 8 bytes that overlap in the middle,
+// instead of a memcpy call. Nothing past w + length is written, and the
+// source always ends at or before w. Shorter strings take memcpy, which beat
+// a branch per length.
+static inline __attribute__((always_inline)) void context_copy(uint8_t *w, const uint8_t *from, size_t length,
+                                                                bool chunked)
+{
+    if (chunked && length >= 8 && length <= 32)
+    {
+        if (length >= 16)
+        {
+            memcpy(w, from, 16);
+            memcpy(w + length - 16, from + length - 16, 16);
+        }
+        else
+        {
+            memcpy(w, from, 8);
+            memcpy(w + length - 8, from + length - 8, 8);
+        }
+        return;
+    }
+
+    memcpy(w, from, length);
+}
+
+// The lzw_decode_copy engine with the bit reader inlined. always_inline so the
+// callers in dispatch.c compile it for their own target ISA.
+//
+// With a predictor, TIFF Predictor=2 is undone as the output is decoded. The
+// dictionary refers to the differenced bytes written since the last CLEAR, so
+// rows are undone at each CLEAR up to the last whole row before it, while
+// they are still in cache, and the rest at the end.
+//
+// -DLZW_STATS builds count it like lzw_decode_checked, so the stats are those
+// of the engine lzw_decode runs.
+static inline __attribute__((always_inline)) size_t context_decode(struct lzw_context *ctx, const uint8_t *in,
+                                                                    size_t in_size, uint8_t *restrict out,
+                                                                    size_t out_size, bool chunked,
+                                                                    const struct lzw_predictor *predictor)
+{
+    struct bit_buffer b;
+    bit_buffer_init(&b, in, in_size);
+
+    uint8_t *w = out;
+    uint8_t *out_end = out + out_size;
+
+    struct code_state state;
+    code_state_clear(&state);
+
+    size_t undone = 0; // rows before it are undone
+    uint32_t previous_offset = 0;
+    uint32_t previous_length = 0;
+    for (;;)
+    {
+        LZW_STAT(bool sample = lzw_stats.codes % LZW_STATS_SAMPLE == 0; uint64_t start = LZW_STAT_CYCLES(sample));
+        if (!bit_buffer_fill(&b, state.bits_count))
+        {
+            break;
+        }
+        uint32_t code = bit_buffer_take(&b, state.bits_count);
+        LZW_STAT(uint64_t read = LZW_STAT_CYCLES(sample); uint64_t looked_up = read; lzw_stats.codes++);
+
+        enum code_kind kind = code_state_classify(&state, code);
+        uint32_t length;
+        if (kind == CODE_LITERAL)
+        {
+            if (w == out_end)
+            {
+                LZW_STAT(lzw_stats_sample(sample, start, read, read, read, read));
+                return -1;
+            }
+            *w = code;
+            length = 1;
+        }
+        else if (kind == CODE_STRING)
+        {
+            length = ctx->lengths[code];
+            LZW_STAT(looked_up = LZW_STAT_CYCLES(sample));
+            if (length > (size_t)(out_end - w))
+            {
+                LZW_STAT(lzw_stats_sample(sample, start, read, looked_up, looked_up, looked_up));
+                return -1;
+            }
+            context_copy(w, out + ctx->offsets[code], length, chunked);
+        }
+        else if (kind == CODE_KWKWK)
+        {
+            length = previous_length + 1;
+            if (length > (size_t)(out_end - w))
+            {
+                LZW_STAT(lzw_stats_sample(sample, start, read, read, read, read));
+                return -1;
+            }
+            context_copy(w, out + previous_offset, previous_length, chunked);
+            w[previous_length] = out[previous_offset];
+            LZW_STAT(lzw_stats.kwkwk++);
+        }
+        else if (kind == CODE_CLEAR)
+        {
+            code_state_clear(&state);
+            LZW_STAT(lzw_stats.clears++; lzw_stats_sample(sample, start, read, read, read, LZW_STAT_CYCLES(sample)));
+            if (predictor != NULL)
+            {
+                undone = predictor_undo_rows(out, undone, w - out, predictor);
+            }
+            continue;
+        }
+        else if (kind == CODE_END)
+        {
+            LZW_STAT(lzw_stats_sample(sample, start, read, read, read, read));
+            break;
+        }
+        else
+        {
+            LZW_STAT(lzw_stats_sample(sample, start, read, read, read, read));
+            return -1;
+        }
+        LZW_STAT(uint64_t written = LZW_STAT_CYCLES(sample); lzw_stats_string(length));
+
+        LZW_STAT(uint32_t bits_count = state.bits_count);
+        uint32_t entry = code_state_advance(&state);
+        if (entry != 0)
+        {
+            ctx->offsets[entry] = previous_offset;
+            ctx->lengths[entry] = previous_length + 1;
+        }
+        LZW_STAT(lzw_stats.width_changes += state.bits_count != bits_count);
+        LZW_STAT(lzw_stats_sample(sample, start, read, looked_up, written, LZW_STAT_CYCLES(sample)));
+
+        previous_offset = w - out;
+        previous_length = length;
+        w += length;
+    }
+
+    if (predictor != NULL)
+    {
+        undone = predictor_undo_rows(out, undone, w - out, predictor);
+        if ((size_t)(w - out) > undone)
+        {
+            predictor_undo(out + undone, w - out - undone, predictor);
+        }
+    }
+    return w - out;
+}
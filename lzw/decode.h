@@ -1,6 +1,42 @@
 #pragma once
 
+#include "predictor.h"
+
 #include <stddef.h>
 #include <stdint.h>
 
+typedef size_t (*lzw_decode_fn)(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size);
+
+// Returns the decoded size or -1 on error; never reads past in_size or writes
+// past the decoded size.
+// In C it is the dispatched kernel: lzw_decode_auto, picked by dispatch.c.
 size_t lzw_decode(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size);
+
+// The prefix-chain C decoder, built in every configuration and counted by
+// -DLZW_STATS builds, with the reason for a failure: INVALID_CODE for a code
+// that is neither in the table nor the next one, OUTPUT_OVERFLOW when a string
+// does not fit in out. Output bounds are checked once per string.
+// *decoded_size is set to the bytes written, on errors too.
+int16_t lzw_decode_checked(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size,
+                           size_t *decoded_size);
+
+// Alternative engine whose dictionary holds (offset, length) pairs into the
+// output instead of prefix chains, so emitting a code is a single memcpy.
+size_t lzw_decode_copy(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size);
+
+// Exact size lzw_decode_copy would decode the stream to, without writing any
+// output, so out can be allocated once; -1 if the stream is invalid.
+size_t lzw_decoded_size(const uint8_t *in, size_t in_size);
+
+// lzw_decode_copy that also undoes TIFF Predictor=2 while decoding, a table
+// generation at a time, so no second pass over the output is needed.
+size_t lzw_decode_predictor(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size,
+                            const struct lzw_predictor *predictor);
+
+// lzw32fast.asm: trusts its input to be a valid stream, reads up to
+// LZW_FAST_IN_SLACK bytes past in_size and may write up to LZW_FAST_OUT_SLACK
+// bytes past out_size, so both buffers must be allocated that much larger.
+#define LZW_FAST_IN_SLACK 4
+#define LZW_FAST_OUT_SLACK 16
+
+size_t lzw_decode_fast(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size);
@@ -0,0 +1,104 @@
+#include "decode.h"
+
+#include "code_state.h"
+#include "common.h"
+#include "decode_table.h"
+#include "reader.h"
+#include "stats.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+int16_t lzw_decode_checked(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size,
+                           size_t *decoded_size)
+{
+    *decoded_size = 0;
+    if (in == NULL || (out == NULL && in_size != 0))
+    {
+        return INVALID_CODE;
+    }
+
+    struct decode_table table;
+    decode_table_init(&table);
+
+    struct reader r;
+    reader_init(&r, in, in_size);
+
+    uint8_t *w = out;
+    uint8_t *out_end = out + out_size;
+    int16_t result = SUCCESS;
+
+    struct code_state state;
+    code_state_clear(&state);
+
+    uint16_t previous_code = CLEAR_CODE;
+    uint16_t code;
+    for (;;)
+    {
+        LZW_STAT(bool sample = lzw_stats.codes % LZW_STATS_SAMPLE == 0; uint64_t start = LZW_STAT_CYCLES(sample));
+        if (!reader_has_next(&r, state.bits_count))
+        {
+            break;
+        }
+        code = reader_next(&r, state.bits_count);
+        LZW_STAT(uint64_t read = LZW_STAT_CYCLES(sample); lzw_stats.codes++);
+
+        enum code_kind kind = code_state_classify(&state, code);
+        if (kind == CODE_CLEAR)
+        {
+            decode_table_reset(&table);
+            code_state_clear(&state);
+            LZW_STAT(lzw_stats.clears++; lzw_stats_sample(sample, start, read, read, read, LZW_STAT_CYCLES(sample)));
+            continue;
+        }
+        else if (kind == CODE_END)
+        {
+            LZW_STAT(lzw_stats_sample(sample, start, read, read, read, read));
+            break;
+        }
+        else if (kind == CODE_INVALID)
+        {
+            LZW_STAT(lzw_stats_sample(sample, start, read, read, read, read));
+            result = INVALID_CODE;
+            break;
+        }
+
+        bool contains = kind != CODE_KWKWK;
+        uint16_t handled_code = contains ? code : previous_code;
+        // One check per string: the code's string plus the KwKwK byte
+        if (decode_table_get_length(&table, handled_code) + !contains > out_end - w)
+        {
+            LZW_STAT(uint64_t looked_up = LZW_STAT_CYCLES(sample));
+            LZW_STAT(lzw_stats_sample(sample, start, read, looked_up, looked_up, looked_up));
+            result = OUTPUT_OVERFLOW;
+            break;
+        }
+        LZW_STAT(uint64_t looked_up = LZW_STAT_CYCLES(sample); uint8_t *string = w);
+
+        w += decode_table_write_bytes(w, handled_code, &table);
+
+        uint8_t append_byte = decode_table_get_first_byte(&table, handled_code);
+
+        if (!contains)
+        {
+            *w++ = append_byte;
+            LZW_STAT(lzw_stats.kwkwk++);
+        }
+        LZW_STAT(uint64_t written = LZW_STAT_CYCLES(sample); lzw_stats_string(w - string));
+
+        // A full table stays as it is until the next clear code
+        LZW_STAT(uint32_t bits_count = state.bits_count);
+        if (code_state_advance(&state) != 0)
+        {
+            decode_table_append(&table, previous_code, append_byte);
+        }
+        LZW_STAT(lzw_stats.width_changes += state.bits_count != bits_count);
+        LZW_STAT(lzw_stats_sample(sample, start, read, looked_up, written, LZW_STAT_CYCLES(sample)));
+
+        previous_code = code;
+    }
+
+    *decoded_size = w - out;
+    return result;
+}
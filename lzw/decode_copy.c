@@ -0,0 +1,112 @@
+#include "decode.h"
+
+#include "code_state.h"
+#include "common.h"
+#include "reader.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Every code past the literals names a string that has already been written
+// to the output, so the dictionary only needs to remember where it is.
+struct copy_table
+{
+    uint32_t offsets[MAX_CODE];
+    uint16_t lengths[MAX_CODE];
+};
+
+size_t lzw_decode_copy(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+{
+    if (in == NULL)
+    {
+        return -1;
+    }
+    if (out == NULL)
+    {
+        if (in_size == 0)
+        {
+            return 0;
+        }
+
+        return -1;
+    }
+
+    struct copy_table table;
+
+    struct reader r;
+    reader_init(&r, in, in_size);
+
+    uint8_t *w = out;
+    uint8_t *out_end = out + out_size;
+
+    struct code_state state;
+    code_state_clear(&state);
+
+    uint32_t previous_offset = 0;
+    uint16_t previous_length = 0;
+    while (reader_has_next(&r, state.bits_count))
+    {
+        uint16_t code = reader_next(&r, state.bits_count);
+
+        uint32_t offset = w - out;
+        enum code_kind kind = code_state_classify(&state, code);
+        uint16_t length;
+        if (kind == CODE_LITERAL)
+        {
+            length = 1;
+            if (w == out_end)
+            {
+                return -1;
+            }
+            *w = code;
+        }
+        else if (kind == CODE_STRING)
+        {
+            length = table.lengths[code];
+            if (length > out_end - w)
+            {
+                return -1;
+            }
+            memcpy(w, out + table.offsets[code], length);
+        }
+        else if (kind == CODE_KWKWK)
+        {
+            // The string is the previous one plus its own first byte, which
+            // is not in the output yet, so it cannot be copied in one go.
+            length = previous_length + 1;
+            if (length > out_end - w)
+            {
+                return -1;
+            }
+            memcpy(w, out + previous_offset, previous_length);
+            w[previous_length] = out[previous_offset];
+        }
+        else if (kind == CODE_CLEAR)
+        {
+            code_state_clear(&state);
+            continue;
+        }
+        else if (kind == CODE_END)
+        {
+            return w - out;
+        }
+        else
+        {
+            return -1;
+        }
+
+        uint32_t entry = code_state_advance(&state);
+        if (entry != 0)
+        {
+            table.offsets[entry] = previous_offset;
+            table.lengths[entry] = previous_length + 1;
+        }
+
+        w += length;
+        previous_offset = offset;
+        previous_length = length;
+    }
+
+    return w - out;
+}
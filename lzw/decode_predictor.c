@@ -0,0 +1,31 @@
+#include "decode.h"
+
+#include "context.h"
+#include "context_kernel.h"
+#include "predictor.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The context kernel undoing the rows of each table generation once the next
+// CLEAR code retires it, so they are undone while they are still in cache.
+size_t lzw_decode_predictor(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size,
+                            const struct lzw_predictor *predictor)
+{
+    if (in == NULL || !predictor_valid(predictor))
+    {
+        return -1;
+    }
+    if (out == NULL)
+    {
+        if (in_size == 0)
+        {
+            return 0;
+        }
+
+        return -1;
+    }
+
+    struct lzw_context ctx;
+    return context_decode(&ctx, in, in_size, out, out_size, false, predictor);
+}
@@ -6,60 +6,111 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#define ENTRY_GET_PREVIOUS_CODE(entry) ((int16_t)((entry) & 0xFFF))
-#define ENTRY_GET_BYTE(entry) ((uint8_t)(((entry) >> 12) & 0xFF))
-#define ENTRY_GET_HAS_VALUE(entry) ((bool)(((entry) >> 20) & 0x1))
-#define ENTRY_PACK(previous_code, byte, has_value)                                                                     \
-    ((uint32_t)((previous_code) & 0xFFF) | (uint32_t)(((byte) & 0xFF) << 12) | (uint32_t)(((has_value) & 0x1) << 20))
+// Codes below next_code are valid, so a reset only rewinds next_code.
+void decode_table_reset(struct decode_table *table)
+{
+    table->next_code = FIRST_CODE;
+}
+
+bool decode_table_contains(struct decode_table const *table, uint16_t code)
+{
+    return code < table->next_code;
+}
 
+#ifdef LZW_SOA_TABLE
 void decode_table_init(struct decode_table *table)
 {
     for (size_t i = 0; i < 256; i++)
     {
-        table->entries[i] = ENTRY_PACK(0, 0, 1);
+        table->previous_codes[i] = 0;
+        table->bytes[i] = i;
+        table->first_bytes[i] = i;
+        table->lengths[i] = 1;
     }
-    for (size_t i = 256; i < MAX_CODE; i++)
-    {
-        table->entries[i] = 0;
-    }
-    table->next_code = FIRST_CODE;
+    decode_table_reset(table);
 }
 
-bool decode_table_contains(struct decode_table const *table, uint16_t code)
+void decode_table_append(struct decode_table *table, int16_t code, uint8_t byte)
 {
-    return ENTRY_GET_HAS_VALUE(table->entries[code]);
+    int16_t next_code = table->next_code;
+    table->previous_codes[next_code] = code;
+    table->bytes[next_code] = byte;
+    table->first_bytes[next_code] = table->first_bytes[code];
+    table->lengths[next_code] = table->lengths[code] + 1;
+    ++table->next_code;
 }
 
-void decode_table_append(struct decode_table *table, int16_t code, uint8_t byte)
+uint16_t decode_table_get_length(struct decode_table const *table, uint16_t code)
 {
-    table->entries[table->next_code] = ENTRY_PACK(code, byte, 1);
-    ++table->next_code;
+    return table->lengths[code];
 }
 
 uint8_t decode_table_get_first_byte(struct decode_table const *table, uint16_t code)
 {
-    while (code >= FIRST_CODE)
+    return table->first_bytes[code];
+}
+
+uint16_t decode_table_write_bytes(uint8_t *w, uint16_t code, struct decode_table const *table)
+{
+    uint16_t length = table->lengths[code];
+
+    for (uint8_t *end = w + length; end != w;)
     {
-        uint32_t entry = table->entries[code];
-        code = ENTRY_GET_PREVIOUS_CODE(entry);
+        *--end = table->bytes[code];
+        code = table->previous_codes[code];
     }
 
-    return code;
+    return length;
 }
+#else
+// Entry layout: bits 0-11 previous code, 12-19 last byte,
+// 32-47 string length, 48-55 first byte of the string.
+#define ENTRY_GET_PREVIOUS_CODE(entry) ((int16_t)((entry) & 0xFFF))
+#define ENTRY_GET_BYTE(entry) ((uint8_t)(((entry) >> 12) & 0xFF))
+#define ENTRY_GET_LENGTH(entry) ((uint16_t)(((entry) >> 32) & 0xFFFF))
+#define ENTRY_GET_FIRST_BYTE(entry) ((uint8_t)(((entry) >> 48) & 0xFF))
+#define ENTRY_PACK(previous_code, byte, length, first_byte)                                                            \
+    ((uint64_t)((previous_code) & 0xFFF) | (uint64_t)(((byte) & 0xFF) << 12) | ((uint64_t)((length) & 0xFFFF) << 32) | \
+     ((uint64_t)((first_byte) & 0xFF) << 48))
 
-uint16_t decode_table_write_bytes(uint8_t *w, uint16_t code, struct decode_table const *table)
+void decode_table_init(struct decode_table *table)
 {
-    if (code < FIRST_CODE)
+    for (size_t i = 0; i < 256; i++)
     {
-        w[0] = code;
-        return 1;
+        table->entries[i] = ENTRY_PACK(0, i, 1, i);
     }
+    decode_table_reset(table);
+}
+
+void decode_table_append(struct decode_table *table, int16_t code, uint8_t byte)
+{
+    uint64_t entry = table->entries[code];
+    table->entries[table->next_code] =
+        ENTRY_PACK(code, byte, ENTRY_GET_LENGTH(entry) + 1, ENTRY_GET_FIRST_BYTE(entry));
+    ++table->next_code;
+}
 
-    uint32_t entry = table->entries[code];
+uint16_t decode_table_get_length(struct decode_table const *table, uint16_t code)
+{
+    return ENTRY_GET_LENGTH(table->entries[code]);
+}
 
-    uint16_t bytes = decode_table_write_bytes(w, ENTRY_GET_PREVIOUS_CODE(entry), table);
+uint8_t decode_table_get_first_byte(struct decode_table const *table, uint16_t code)
+{
+    return ENTRY_GET_FIRST_BYTE(table->entries[code]);
+}
 
-    w[bytes] = ENTRY_GET_BYTE(entry);
+uint16_t decode_table_write_bytes(uint8_t *w, uint16_t code, struct decode_table const *table)
+{
+    uint16_t length = ENTRY_GET_LENGTH(table->entries[code]);
+
+    for (uint8_t *end = w + length; end != w;)
+    {
+        uint64_t entry = table->entries[code];
+        *--end = ENTRY_GET_BYTE(entry);
+        code = ENTRY_GET_PREVIOUS_CODE(entry);
+    }
 
-    return bytes + 1;
+    return length;
 }
+#endif
@@ -6,14 +6,30 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#ifdef LZW_SOA_TABLE
+// Structure of arrays: a chain step in decode_table_write_bytes is two plain
+// loads from 12 KB of previous_codes and bytes instead of an extract from 32 KB
+// of packed entries.
 struct decode_table
 {
-    uint32_t entries[MAX_CODE];
+    uint16_t previous_codes[MAX_CODE];
+    uint8_t bytes[MAX_CODE];
+    uint8_t first_bytes[MAX_CODE];
+    uint16_t lengths[MAX_CODE];
     int16_t next_code;
 };
+#else
+struct decode_table
+{
+    uint64_t entries[MAX_CODE];
+    int16_t next_code;
+};
+#endif
 
 extern void decode_table_init(struct decode_table *table);
+extern void decode_table_reset(struct decode_table *table);
 extern bool decode_table_contains(struct decode_table const *table, uint16_t code);
 extern void decode_table_append(struct decode_table *table, int16_t code, uint8_t byte);
+extern uint16_t decode_table_get_length(struct decode_table const *table, uint16_t code);
 extern uint8_t decode_table_get_first_byte(struct decode_table const *table, uint16_t code);
 extern uint16_t decode_table_write_bytes(uint8_t *w, uint16_t code, struct decode_table const *table);
@@ -0,0 +1,72 @@
+#include "decode.h"
+
+#include "bit_buffer.h"
+#include "code_state.h"
+#include "common.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Runs the decoder state machine of lzw_decode_copy with only the string
+// lengths of the dictionary, so nothing is written and nothing is copied.
+size_t lzw_decoded_size(const uint8_t *in, size_t in_size)
+{
+    if (in == NULL)
+    {
+        return -1;
+    }
+
+    uint16_t lengths[MAX_CODE];
+
+    struct bit_buffer b;
+    bit_buffer_init(&b, in, in_size);
+
+    struct code_state state;
+    code_state_clear(&state);
+
+    size_t size = 0;
+    uint32_t previous_length = 0;
+    while (bit_buffer_fill(&b, state.bits_count))
+    {
+        uint32_t code = bit_buffer_take(&b, state.bits_count);
+
+        enum code_kind kind = code_state_classify(&state, code);
+        uint32_t length;
+        if (kind == CODE_LITERAL)
+        {
+            length = 1;
+        }
+        else if (kind == CODE_STRING)
+        {
+            length = lengths[code];
+        }
+        else if (kind == CODE_KWKWK)
+        {
+            length = previous_length + 1;
+        }
+        else if (kind == CODE_CLEAR)
+        {
+            code_state_clear(&state);
+            continue;
+        }
+        else if (kind == CODE_END)
+        {
+            break;
+        }
+        else
+        {
+            return -1;
+        }
+
+        uint32_t entry = code_state_advance(&state);
+        if (entry != 0)
+        {
+            lengths[entry] = previous_length + 1;
+        }
+
+        size += length;
+        previous_length = length;
+    }
+
+    return size;
+}
@@ -0,0 +1,121 @@
+#include "dispatch.h"
+
+#include "context.h"
+#include "context_kernel.h"
+#include "decode.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t kernel_baseline(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+{
+    struct lzw_context ctx;
+    return context_decode(&ctx, in, in_size, out, out_size, false, NULL);
+}
+
+__attribute__((target("bmi2"))) static size_t kernel_bmi2(const uint8_t *in, size_t in_size, uint8_t *restrict out,
+                                                           size_t out_size)
+{
+    struct lzw_context ctx;
+    return context_decode(&ctx, in, in_size, out, out_size, false, NULL);
+}
+
+__attribute__((target("avx2,bmi2"))) static size_t kernel_avx2(const uint8_t *in, size_t in_size,
+                                                               uint8_t *restrict out, size_t out_size)
+{
+    struct lzw_context ctx;
+    return context_decode(&ctx, in, in_size, out, out_size, true, NULL);
+}
+
+static const struct
+{
+    const char *name;
+    lzw_decode_fn decode;
+} kernels[LZW_KERNEL_COUNT] = {
+    [LZW_KERNEL_BASELINE] = {"baseline", kernel_baseline},
+    [LZW_KERNEL_BMI2] = {"bmi2", kernel_bmi2},
+    [LZW_KERNEL_AVX2] = {"avx2", kernel_avx2},
+};
+
+// Default order, fastest first, from best-of-6 MB/s of each kernel at -O2 on
+// the development host; cpuid only rules kernels out.
+//            test_data/in  1000.enc  gradient  rand4  text
+//   avx2          280        436        253     679    256
+//   bmi2          293        440        241     614    255
+//   baseline      257        336        248     616    252
+static const enum lzw_kernel preference[] = {LZW_KERNEL_AVX2, LZW_KERNEL_BMI2, LZW_KERNEL_BASELINE};
+
+static enum lzw_kernel selected = LZW_KERNEL_BASELINE;
+
+bool lzw_kernel_supported(enum lzw_kernel kernel)
+{
+    switch (kernel)
+    {
+    case LZW_KERNEL_BASELINE:
+        return true;
+    case LZW_KERNEL_BMI2:
+        return __builtin_cpu_supports("bmi2");
+    case LZW_KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2");
+    default:
+        return false;
+    }
+}
+
+__attribute__((constructor)) static void kernel_resolve(void)
+{
+    // Constructors may run before the runtime has read cpuid
+    __builtin_cpu_init();
+
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++)
+    {
+        if (lzw_kernel_supported(preference[i]))
+        {
+            selected = preference[i];
+            break;
+        }
+    }
+
+    const char *forced = getenv("LZW_KERNEL");
+    for (int kernel = 0; forced != NULL && kernel < LZW_KERNEL_COUNT; kernel++)
+    {
+        if (strcmp(forced, kernels[kernel].name) == 0 && lzw_kernel_supported(kernel))
+        {
+            selected = kernel;
+        }
+    }
+}
+
+size_t lzw_decode_auto(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+{
+    if (in == NULL || (out == NULL && out_size != 0))
+    {
+        return -1;
+    }
+
+    return kernels[selected].decode(in, in_size, out, out_size);
+}
+
+enum lzw_kernel lzw_kernel_selected(void)
+{
+    return selected;
+}
+
+bool lzw_kernel_select(enum lzw_kernel kernel)
+{
+    if (kernel >= LZW_KERNEL_COUNT || !lzw_kernel_supported(kernel))
+    {
+        return false;
+    }
+
+    selected = kernel;
+    return true;
+}
+
+const char *lzw_kernel_name(enum lzw_kernel kernel)
+{
+    return kernel < LZW_KERNEL_COUNT ? kernels[kernel].name : "unknown";
+}
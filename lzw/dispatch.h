@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Builds of the lzw_decode_copy engine for different x86 extensions, picked
+// once at load time: the fastest in a measured ranking that cpuid reports.
+// BMI2 gives shrx/shlx for the bit reader, AVX2 adds inline string copies.
+enum lzw_kernel
+{
+    LZW_KERNEL_BASELINE,
+    LZW_KERNEL_BMI2,
+    LZW_KERNEL_AVX2,
+    LZW_KERNEL_COUNT,
+};
+
+// Decodes with the selected kernel; nothing past the decoded size is written.
+size_t lzw_decode_auto(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size);
+
+// The fastest kernel the CPU supports, or the one named by the LZW_KERNEL
+// environment variable ("baseline", "bmi2", "avx2") if it is supported.
+enum lzw_kernel lzw_kernel_selected(void);
+
+bool lzw_kernel_supported(enum lzw_kernel kernel);
+
+// Forces a kernel for tests and benchmarks; false if the CPU lacks it. Not
+// thread-safe against concurrent lzw_decode_auto calls.
+bool lzw_kernel_select(enum lzw_kernel kernel);
+
+const char *lzw_kernel_name(enum lzw_kernel kernel);
@@ -0,0 +1,161 @@
+#include "encode.h"
+
+#include "common.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// The encoder emits CLEAR_CODE once next_code reaches this value, which keeps
+// the decoder's table (one entry behind the encoder's) below MAX_CODE - 2.
+#define ENCODE_LAST_CODE (MAX_CODE - 2)
+
+// Open addressing hash of (prefix code, byte) -> code. A slot holds
+// key << 12 | code, where key = prefix << 8 | byte; 0 marks an empty slot since
+// every stored code is at least FIRST_CODE. 8192 slots keep the load factor
+// below one half in 32 KB.
+#define HASH_BITS 13
+#define HASH_SIZE (1 << HASH_BITS)
+#define HASH_INDEX(key) (((uint32_t)(key) * 2654435761u) >> (32 - HASH_BITS))
+
+struct encode_writer
+{
+    uint8_t *w;
+    uint8_t *out_end;
+    uint32_t buffer;
+    uint8_t bits_pending;
+};
+
+static bool encode_put(struct encode_writer *wr, uint16_t code, uint8_t bits_count)
+{
+    wr->buffer = (wr->buffer << bits_count) | code;
+    wr->bits_pending += bits_count;
+
+    while (wr->bits_pending >= 8)
+    {
+        if (wr->w == wr->out_end)
+        {
+            return false;
+        }
+        wr->bits_pending -= 8;
+        *wr->w++ = wr->buffer >> wr->bits_pending;
+    }
+
+    return true;
+}
+
+static bool encode_flush(struct encode_writer *wr)
+{
+    if (wr->bits_pending == 0)
+    {
+        return true;
+    }
+    if (wr->w == wr->out_end)
+    {
+        return false;
+    }
+    *wr->w++ = wr->buffer << (8 - wr->bits_pending);
+    wr->bits_pending = 0;
+
+    return true;
+}
+
+size_t lzw_encode(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+{
+    if (in == NULL && in_size != 0)
+    {
+        return -1;
+    }
+    if (out == NULL)
+    {
+        return -1;
+    }
+
+    uint32_t hash[HASH_SIZE];
+    memset(hash, 0, sizeof(hash));
+
+    struct encode_writer wr = {out, out + out_size, 0, 0};
+
+    uint16_t next_code = FIRST_CODE;
+    uint8_t bits_count = 9;
+
+    if (!encode_put(&wr, CLEAR_CODE, bits_count))
+    {
+        return -1;
+    }
+
+    const uint8_t *end = in + in_size;
+    const uint8_t *r = in;
+
+    if (r != end)
+    {
+        uint16_t prefix = *r++;
+
+        for (;;)
+        {
+            uint8_t byte = 0;
+            bool last = r == end;
+
+            if (!last)
+            {
+                byte = *r++;
+
+                uint32_t key = (uint32_t)prefix << 8 | byte;
+                uint32_t index = HASH_INDEX(key);
+                uint32_t slot;
+                while ((slot = hash[index]) != 0 && (slot >> 12) != key)
+                {
+                    index = (index + 1) & (HASH_SIZE - 1);
+                }
+
+                if (slot != 0)
+                {
+                    prefix = slot & 0xFFF;
+                    continue;
+                }
+
+                hash[index] = key << 12 | next_code;
+            }
+
+            if (!encode_put(&wr, prefix, bits_count))
+            {
+                return -1;
+            }
+
+            // The decoder adds an entry for every code but the first after
+            // CLEAR_CODE, so the width is tracked on the same schedule even for
+            // the last code.
+            ++next_code;
+
+            if (next_code == ENCODE_LAST_CODE)
+            {
+                if (!encode_put(&wr, CLEAR_CODE, bits_count))
+                {
+                    return -1;
+                }
+                memset(hash, 0, sizeof(hash));
+                next_code = FIRST_CODE;
+                bits_count = 9;
+            }
+            else if (next_code == (1u << bits_count) && bits_count < MAX_BITS_COUNT)
+            {
+                bits_count++;
+            }
+
+            if (last)
+            {
+                break;
+            }
+
+            prefix = byte;
+        }
+    }
+
+    if (!encode_put(&wr, END_OF_INFORMATION, bits_count) || !encode_flush(&wr))
+    {
+        return -1;
+    }
+
+    return wr.w - out;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Worst case output size: at most one 12-bit code per input byte, plus the
+// CLEAR_CODE written every few thousand codes and the final codes.
+#define LZW_ENCODE_BOUND(size) ((size) + (size) / 2 + (size) / 1024 + 8)
+
+// TIFF variant: MSB-first codes of 9 to 12 bits with early change, starting
+// with CLEAR_CODE, emitting CLEAR_CODE whenever the table fills up and ending
+// with END_OF_INFORMATION. Returns the encoded size or -1 if out is too small.
+size_t lzw_encode(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size);
@@ -0,0 +1,300 @@
+#include "common.h"
+#include "context.h"
+#include "decode.h"
+#include "dispatch.h"
+#include "encode.h"
+#include "predictor.h"
+#include "stream.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Differential harness over every decoder linked in. An input is a mode byte,
+// then for FUZZ_DECODE a big-endian 16-bit out_size and an arbitrary stream,
+// for FUZZ_ROUND_TRIP plaintext to encode. Streams are decoded into buffers of
+// exactly out_size bytes, so AddressSanitizer catches reads past the input and
+// writes past out_size, and every engine must return what lzw_decode_checked
+// returns and write the same bytes.
+enum fuzz_mode
+{
+    FUZZ_DECODE,
+    FUZZ_ROUND_TRIP,
+};
+
+#define FUZZ_STREAM_CHUNK 7
+
+static size_t decode_checked(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+{
+    size_t decoded_size;
+    int16_t result = lzw_decode_checked(in, in_size, out, out_size, &decoded_size);
+    if (decoded_size > out_size || (result != SUCCESS && result != INVALID_CODE && result != OUTPUT_OVERFLOW))
+    {
+        abort();
+    }
+    return result == SUCCESS ? decoded_size : (size_t)-1;
+}
+
+static size_t decode_context(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+{
+    static struct lzw_context ctx;
+    return lzw_decode_context(&ctx, in, in_size, out, out_size);
+}
+
+#define FUZZ_AUTO(kernel)                                                                                              \
+    static size_t decode_auto_##kernel(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)    \
+    {                                                                                                                  \
+        lzw_kernel_select(LZW_KERNEL_##kernel);                                                                        \
+        return lzw_decode_auto(in, in_size, out, out_size);                                                            \
+    }
+FUZZ_AUTO(BASELINE)
+FUZZ_AUTO(BMI2)
+FUZZ_AUTO(AVX2)
+
+static const struct
+{
+    const char *name;
+    lzw_decode_fn decode;
+    enum lzw_kernel kernel;
+} engines[] = {
+    {"lzw_decode", lzw_decode, LZW_KERNEL_BASELINE},
+    {"lzw_decode_copy", lzw_decode_copy, LZW_KERNEL_BASELINE},
+    {"lzw_decode_context", decode_context, LZW_KERNEL_BASELINE},
+    {"lzw_decode_auto baseline", decode_auto_BASELINE, LZW_KERNEL_BASELINE},
+    {"lzw_decode_auto bmi2", decode_auto_BMI2, LZW_KERNEL_BMI2},
+    {"lzw_decode_auto avx2", decode_auto_AVX2, LZW_KERNEL_AVX2},
+};
+
+static void fuzz_fail(const char *name, const char *what, size_t expected, size_t actual)
+{
+    fprintf(stderr, "%s: %s (lzw_decode_checked %zu, got %zu)\n", name, what, expected, actual);
+    abort();
+}
+
+// Feeds in FUZZ_STREAM_CHUNK bytes at a time into one window of out_size.
+static size_t decode_stream(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size)
+{
+    static struct lzw_stream s;
+    lzw_stream_init(&s);
+
+    size_t decoded_size = 0;
+    size_t offset = 0;
+    while (offset < in_size && decoded_size < out_size)
+    {
+        size_t chunk = in_size - offset < FUZZ_STREAM_CHUNK ? in_size - offset : FUZZ_STREAM_CHUNK;
+        size_t used;
+        size_t written = lzw_stream_feed(&s, in + offset, chunk, &used, out + decoded_size, out_size - decoded_size);
+        if (written == (size_t)-1)
+        {
+            return -1;
+        }
+        offset += used;
+        decoded_size += written;
+    }
+    size_t written = lzw_stream_finish(&s, out + decoded_size, out_size - decoded_size);
+    return written == (size_t)-1 ? (size_t)-1 : decoded_size + written;
+}
+
+// Decodes with every engine and compares against lzw_decode_checked. The
+// stream engine stops at a full output instead of failing, so it is only
+// compared when the stream decodes.
+static void fuzz_decode(const uint8_t *in, size_t in_size, size_t out_size)
+{
+    uint8_t *expected = malloc(out_size > 0 ? out_size : 1);
+    uint8_t *out = malloc(out_size > 0 ? out_size : 1);
+    if (expected == NULL || out == NULL)
+    {
+        abort();
+    }
+
+    size_t expected_size = decode_checked(in, in_size, expected, out_size);
+
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++)
+    {
+        if (!lzw_kernel_supported(engines[e].kernel))
+        {
+            continue;
+        }
+        size_t size = engines[e].decode(in, in_size, out, out_size);
+        if (size != expected_size)
+        {
+            fuzz_fail(engines[e].name, "return value differs", expected_size, size);
+        }
+        if (size != (size_t)-1 && memcmp(out, expected, size) != 0)
+        {
+            fuzz_fail(engines[e].name, "output differs", expected_size, size);
+        }
+    }
+
+    if (expected_size != (size_t)-1)
+    {
+        size_t size = decode_stream(in, in_size, out, out_size);
+        if (size != expected_size || memcmp(out, expected, size) != 0)
+        {
+            fuzz_fail("lzw_stream", "output differs", expected_size, size);
+        }
+    }
+
+    struct lzw_predictor predictor = {16, 1, 1, false};
+    size_t size = lzw_decode_predictor(in, in_size, out, out_size, &predictor);
+    if (size != expected_size)
+    {
+        fuzz_fail("lzw_decode_predictor", "return value differs", expected_size, size);
+    }
+    if (size != (size_t)-1)
+    {
+        for (size_t row = 0; row < expected_size; row += predictor.row_size)
+        {
+            size_t row_size = expected_size - row < predictor.row_size ? expected_size - row : predictor.row_size;
+            predictor_undo(expected + row, row_size, &predictor);
+        }
+        if (memcmp(out, expected, size) != 0)
+        {
+            fuzz_fail("lzw_decode_predictor", "output differs", expected_size, size);
+        }
+    }
+
+    free(expected);
+    free(out);
+}
+
+// Encodes plain and decodes it back with every engine into exactly its size.
+static void fuzz_round_trip(const uint8_t *plain, size_t plain_size)
+{
+    size_t encoded_size = LZW_ENCODE_BOUND(plain_size);
+    uint8_t *encoded = malloc(encoded_size);
+    uint8_t *out = malloc(plain_size > 0 ? plain_size : 1);
+    if (encoded == NULL || out == NULL)
+    {
+        abort();
+    }
+
+    encoded_size = lzw_encode(plain, plain_size, encoded, encoded_size);
+    if (encoded_size == (size_t)-1)
+    {
+        fuzz_fail("lzw_encode", "encoding failed", plain_size, encoded_size);
+    }
+    size_t size = decode_checked(encoded, encoded_size, out, plain_size);
+    if (size != plain_size || memcmp(out, plain, plain_size) != 0)
+    {
+        fuzz_fail("lzw_decode_checked", "round trip differs", plain_size, size);
+    }
+    fuzz_decode(encoded, encoded_size, plain_size);
+
+#ifdef LZW_FAST
+    // Trusts its input, so only valid streams and with its slack
+    uint8_t *fast_in = malloc(encoded_size + LZW_FAST_IN_SLACK);
+    uint8_t *fast_out = malloc(plain_size + LZW_FAST_OUT_SLACK);
+    if (fast_in == NULL || fast_out == NULL)
+    {
+        abort();
+    }
+    memcpy(fast_in, encoded, encoded_size);
+    size = lzw_decode_fast(fast_in, encoded_size, fast_out, plain_size);
+    if (size != plain_size || memcmp(fast_out, plain, plain_size) != 0)
+    {
+        fuzz_fail("lzw_decode_fast", "round trip differs", plain_size, size);
+    }
+    free(fast_in);
+    free(fast_out);
+#endif
+
+    free(encoded);
+    free(out);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size < 1)
+    {
+        return 0;
+    }
+
+    enum lzw_kernel kernel = lzw_kernel_selected();
+    if (data[0] % 2 == FUZZ_ROUND_TRIP)
+    {
+        fuzz_round_trip(data + 1, size - 1);
+    }
+    else if (size >= 3)
+    {
+        fuzz_decode(data + 3, size - 3, (size_t)data[1] << 8 | data[2]);
+    }
+    lzw_kernel_select(kernel);
+    return 0;
+}
+
+#ifdef LZW_FUZZ_STANDALONE
+#define FUZZ_ITERATIONS 100000
+#define FUZZ_MAX_INPUT (1 << 16)
+
+static void fuzz_run(const uint8_t *data, size_t size)
+{
+    // An exact copy, so reads past size hit the redzone
+    uint8_t *copy = malloc(size > 0 ? size : 1);
+    memcpy(copy, data, size);
+    LLVMFuzzerTestOneInput(copy, size);
+    free(copy);
+}
+
+// Without libFuzzer: replays the files given as arguments, such as the seed
+// corpus in test_data/fuzz, or runs FUZZ_ITERATIONS inputs of random
+// plaintext, half of them encoded and with random bits flipped.
+int main(int argc, char *argv[])
+{
+    static uint8_t data[FUZZ_MAX_INPUT];
+    for (int i = 1; i < argc; i++)
+    {
+        FILE *f = fopen(argv[i], "rb");
+        if (f == NULL)
+        {
+            fprintf(stderr, "%s: cannot open\n", argv[i]);
+            return 1;
+        }
+        size_t size = fread(data, 1, sizeof(data), f);
+        fclose(f);
+        fuzz_run(data, size);
+    }
+    if (argc > 1)
+    {
+        printf("%d inputs, no failures\n", argc - 1);
+        return 0;
+    }
+
+    srand(1);
+    uint8_t plain[4096];
+    for (int iteration = 0; iteration < FUZZ_ITERATIONS; iteration++)
+    {
+        size_t plain_size = rand() % sizeof(plain);
+        unsigned alphabet = 1 + rand() % 256;
+        for (size_t i = 0; i < plain_size; i++)
+        {
+            plain[i] = rand() % alphabet;
+        }
+
+        if (iteration % 2 == 0)
+        {
+            data[0] = FUZZ_ROUND_TRIP;
+            memcpy(data + 1, plain, plain_size);
+            fuzz_run(data, 1 + plain_size);
+            continue;
+        }
+
+        size_t encoded_size = lzw_encode(plain, plain_size, data + 3, sizeof(data) - 3);
+        size_t out_size = rand() % 2 ? plain_size : rand() % (plain_size + 2);
+        data[0] = FUZZ_DECODE;
+        data[1] = out_size >> 8;
+        data[2] = out_size;
+        for (int flips = rand() % 4; flips > 0 && encoded_size > 0; flips--)
+        {
+            data[3 + rand() % encoded_size] ^= 1 << rand() % 8;
+        }
+        size_t size = 3 + (rand() % 8 == 0 ? rand() % (encoded_size + 1) : encoded_size);
+        fuzz_run(data, size);
+    }
+    printf("%d inputs, no failures\n", FUZZ_ITERATIONS);
+    return 0;
+}
+#endif
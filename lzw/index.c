@@ -0,0 +1,367 @@
+#include "index.h"
+
+#include "code_state.h"
+#include "common.h"
+#include "decode_table.h"
+#include "reader.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INDEX_MAGIC "LZWI"
+#define INDEX_VERSION 1
+#define INDEX_HEADER_SIZE 32
+
+// Adds the dictionary entry a code implies and returns the length of its
+// string, or 0 if the code is invalid. CLEAR_CODE and END_OF_INFORMATION are
+// handled by the callers.
+static uint16_t index_apply_code(struct decode_table *table, struct code_state *state, uint16_t previous_code,
+                                 uint16_t code)
+{
+    enum code_kind kind = code_state_classify(state, code);
+    if (kind == CODE_INVALID)
+    {
+        return 0;
+    }
+
+    uint8_t append_byte = decode_table_get_first_byte(table, kind != CODE_KWKWK ? code : previous_code);
+    if (code_state_advance(state) != 0)
+    {
+        decode_table_append(table, previous_code, append_byte);
+    }
+
+    return decode_table_get_length(table, code);
+}
+
+static bool index_push(struct lzw_index *index, size_t *capacity, uint64_t in_bit, uint64_t out_offset)
+{
+    // A CLEAR_CODE right after another checkpoint restarts nothing new
+    if (index->count > 0 && index->checkpoints[index->count - 1].out_offset == out_offset)
+    {
+        index->checkpoints[index->count - 1].in_bit = in_bit;
+        return true;
+    }
+
+    if (index->count == *capacity)
+    {
+        size_t new_capacity = *capacity > 0 ? *capacity * 2 : 16;
+        struct lzw_checkpoint *checkpoints = realloc(index->checkpoints, new_capacity * sizeof(*checkpoints));
+        if (checkpoints == NULL)
+        {
+            return false;
+        }
+        index->checkpoints = checkpoints;
+        *capacity = new_capacity;
+    }
+
+    index->checkpoints[index->count].in_bit = in_bit;
+    index->checkpoints[index->count].out_offset = out_offset;
+    index->count++;
+    return true;
+}
+
+int16_t lzw_index_build(struct lzw_index *index, const uint8_t *in, size_t in_size)
+{
+    index->in_size = in_size;
+    index->decoded_size = 0;
+    index->count = 0;
+    index->checkpoints = NULL;
+
+    if (in == NULL)
+    {
+        return INVALID_CODE;
+    }
+
+    size_t capacity = 0;
+    if (!index_push(index, &capacity, 0, 0))
+    {
+        return INVALID_INDEX;
+    }
+
+    struct decode_table table;
+    decode_table_init(&table);
+
+    struct reader r;
+    reader_init(&r, in, in_size);
+
+    struct code_state state;
+    code_state_clear(&state);
+
+    uint64_t position = 0;
+    uint16_t previous_code = CLEAR_CODE;
+    while (reader_has_next(&r, state.bits_count))
+    {
+        uint16_t code = reader_next(&r, state.bits_count);
+
+        if (code == CLEAR_CODE)
+        {
+            decode_table_reset(&table);
+            code_state_clear(&state);
+            if (!index_push(index, &capacity, (uint64_t)r.byte_index * 8 - r.bits_available, position))
+            {
+                lzw_index_free(index);
+                return INVALID_INDEX;
+            }
+            continue;
+        }
+        else if (code == END_OF_INFORMATION)
+        {
+            break;
+        }
+
+        uint16_t length = index_apply_code(&table, &state, previous_code, code);
+        if (length == 0)
+        {
+            lzw_index_free(index);
+            return INVALID_CODE;
+        }
+
+        position += length;
+        previous_code = code;
+    }
+
+    index->decoded_size = position;
+    return SUCCESS;
+}
+
+void lzw_index_free(struct lzw_index *index)
+{
+    free(index->checkpoints);
+    index->checkpoints = NULL;
+    index->count = 0;
+}
+
+static void index_put_u64(uint8_t *p, uint64_t value)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t index_get_u64(const uint8_t *p)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        value |= (uint64_t)p[i] << (8 * i);
+    }
+    return value;
+}
+
+int16_t lzw_index_save(const struct lzw_index *index, const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL)
+    {
+        return INVALID_INDEX;
+    }
+
+    uint8_t header[INDEX_HEADER_SIZE] = INDEX_MAGIC;
+    header[4] = INDEX_VERSION;
+    index_put_u64(header + 8, index->in_size);
+    index_put_u64(header + 16, index->decoded_size);
+    index_put_u64(header + 24, index->count);
+    bool ok = fwrite(header, 1, sizeof(header), f) == sizeof(header);
+
+    for (size_t i = 0; ok && i < index->count; i++)
+    {
+        uint8_t entry[16];
+        index_put_u64(entry, index->checkpoints[i].in_bit);
+        index_put_u64(entry + 8, index->checkpoints[i].out_offset);
+        ok = fwrite(entry, 1, sizeof(entry), f) == sizeof(entry);
+    }
+
+    if (fclose(f) != 0)
+    {
+        ok = false;
+    }
+    return ok ? SUCCESS : INVALID_INDEX;
+}
+
+int16_t lzw_index_load(struct lzw_index *index, const char *path)
+{
+    index->count = 0;
+    index->checkpoints = NULL;
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        return INVALID_INDEX;
+    }
+
+    uint8_t header[INDEX_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), f) != sizeof(header) || memcmp(header, INDEX_MAGIC, 4) != 0 ||
+        header[4] != INDEX_VERSION || header[5] != 0 || header[6] != 0 || header[7] != 0)
+    {
+        fclose(f);
+        return INVALID_INDEX;
+    }
+
+    index->in_size = index_get_u64(header + 8);
+    index->decoded_size = index_get_u64(header + 16);
+    uint64_t count = index_get_u64(header + 24);
+
+    // Every checkpoint but the first follows a 9-bit CLEAR_CODE
+    if (index->in_size > UINT64_MAX / 8 || count == 0 || count - 1 > index->in_size * 8 / 9 ||
+        count > SIZE_MAX / sizeof(*index->checkpoints))
+    {
+        fclose(f);
+        return INVALID_INDEX;
+    }
+
+    index->checkpoints = malloc(count * sizeof(*index->checkpoints));
+    if (index->checkpoints == NULL)
+    {
+        fclose(f);
+        return INVALID_INDEX;
+    }
+
+    // Sorted, inside the stream and the output, starting at output offset 0,
+    // so lzw_decode_range can trust them.
+    bool ok = true;
+    for (uint64_t i = 0; ok && i < count; i++)
+    {
+        uint8_t entry[16];
+        if (fread(entry, 1, sizeof(entry), f) != sizeof(entry))
+        {
+            ok = false;
+            break;
+        }
+
+        struct lzw_checkpoint checkpoint = {index_get_u64(entry), index_get_u64(entry + 8)};
+        if (i == 0)
+        {
+            ok = checkpoint.out_offset == 0;
+        }
+        else
+        {
+            const struct lzw_checkpoint *previous = &index->checkpoints[i - 1];
+            ok = checkpoint.in_bit > previous->in_bit && checkpoint.out_offset > previous->out_offset;
+        }
+        ok = ok && checkpoint.in_bit <= index->in_size * 8 && checkpoint.out_offset <= index->decoded_size;
+
+        index->checkpoints[i] = checkpoint;
+    }
+    fclose(f);
+
+    if (!ok)
+    {
+        lzw_index_free(index);
+        return INVALID_INDEX;
+    }
+
+    index->count = count;
+    return SUCCESS;
+}
+
+size_t lzw_decode_range(const uint8_t *in, size_t in_size, const struct lzw_index *index, uint64_t offset,
+                        uint8_t *restrict out, size_t size)
+{
+    if (in == NULL || index == NULL || index->count == 0 || index->in_size != in_size || (out == NULL && size != 0))
+    {
+        return -1;
+    }
+    if (offset >= index->decoded_size || size == 0)
+    {
+        return 0;
+    }
+    if (size > index->decoded_size - offset)
+    {
+        size = index->decoded_size - offset;
+    }
+
+    // Last checkpoint at or before offset
+    size_t low = 0;
+    size_t high = index->count;
+    while (high - low > 1)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (index->checkpoints[middle].out_offset <= offset)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    const struct lzw_checkpoint *checkpoint = &index->checkpoints[low];
+
+    struct decode_table table;
+    decode_table_init(&table);
+
+    struct reader r;
+    size_t start_byte = checkpoint->in_bit / 8;
+    reader_init(&r, in + start_byte, in_size - start_byte);
+
+    uint8_t skip_bits = checkpoint->in_bit % 8;
+    if (skip_bits != 0)
+    {
+        if (!reader_has_next(&r, skip_bits))
+        {
+            return -1;
+        }
+        reader_next(&r, skip_bits);
+    }
+
+    // Strings that straddle the window are written here first
+    uint8_t string[MAX_CODE];
+
+    uint64_t position = checkpoint->out_offset;
+    uint64_t end = offset + size;
+    struct code_state state;
+    code_state_clear(&state);
+
+    uint16_t previous_code = CLEAR_CODE;
+    while (position < end && reader_has_next(&r, state.bits_count))
+    {
+        uint16_t code = reader_next(&r, state.bits_count);
+
+        if (code == CLEAR_CODE)
+        {
+            decode_table_reset(&table);
+            code_state_clear(&state);
+            continue;
+        }
+        else if (code == END_OF_INFORMATION)
+        {
+            break;
+        }
+
+        uint16_t length = index_apply_code(&table, &state, previous_code, code);
+        if (length == 0)
+        {
+            return -1;
+        }
+
+        if (position + length > offset)
+        {
+            if (position >= offset && position + length <= end)
+            {
+                decode_table_write_bytes(out + (position - offset), code, &table);
+            }
+            else
+            {
+                decode_table_write_bytes(string, code, &table);
+                uint64_t from = position < offset ? offset - position : 0;
+                uint64_t to = position + length > end ? end - position : length;
+                memcpy(out + (position + from - offset), string + from, to - from);
+            }
+        }
+
+        position += length;
+        previous_code = code;
+    }
+
+    // Fewer bytes than the index promised: the stream is not the indexed one
+    if (position < end)
+    {
+        return -1;
+    }
+    return size;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A place where decoding can start: the bit right after a CLEAR_CODE, or the
+// start of the stream, and the offset of the output produced there.
+struct lzw_checkpoint
+{
+    uint64_t in_bit;
+    uint64_t out_offset;
+};
+
+// Checkpoints of one stream sorted by position; the first is at output
+// offset 0.
+struct lzw_index
+{
+    uint64_t in_size;
+    uint64_t decoded_size;
+    size_t count;
+    struct lzw_checkpoint *checkpoints;
+};
+
+// Decodes the whole stream once, recording a checkpoint at every CLEAR_CODE.
+// Returns SUCCESS, INVALID_CODE or INVALID_INDEX if out of memory; on success
+// release with lzw_index_free.
+int16_t lzw_index_build(struct lzw_index *index, const uint8_t *in, size_t in_size);
+
+void lzw_index_free(struct lzw_index *index);
+
+// On-disk format, little-endian: "LZWI", version (u32), in_size,
+// decoded_size, count (u64), then count (in_bit, out_offset) pairs (u64).
+// Return SUCCESS or INVALID_INDEX.
+int16_t lzw_index_save(const struct lzw_index *index, const char *path);
+int16_t lzw_index_load(struct lzw_index *index, const char *path);
+
+// Decodes the decoded bytes [offset, offset + size) of the stream index was
+// built for, starting at the last checkpoint at or before offset. Returns the
+// number of bytes written, less than size at the end of the data, or -1 on
+// error.
+size_t lzw_decode_range(const uint8_t *in, size_t in_size, const struct lzw_index *index, uint64_t offset,
+                        uint8_t *restrict out, size_t size);
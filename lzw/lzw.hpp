@@ -0,0 +1,338 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// Header-only LZW decoder specialized at compile time on the variant, so the
+// bit order, code widths, early change and special codes are constants in the
+// inner loop. Returns the decoded size or -1 like the C decoders.
+namespace lzw
+{
+
+enum class bit_order
+{
+    msb_first,
+    lsb_first,
+};
+
+// RootBits: literal size, the first codes are RootBits + 1 bits wide.
+// EarlyChange: widen codes once next_code + EarlyChange reaches 1 << width.
+// GroupPadding: codes come in groups of 8 and the rest of a group is skipped
+// whenever the width changes (Unix compress).
+template <bit_order Order, unsigned RootBits, unsigned MaxBits, unsigned EarlyChange, bool HasClear, bool HasEnd,
+          bool GroupPadding>
+struct variant
+{
+    static_assert(RootBits >= 2 && RootBits <= 8, "literals are 2 to 8 bits");
+    static_assert(MaxBits > RootBits && MaxBits <= 16, "codes are at most 16 bits");
+    static_assert(EarlyChange <= 1, "early change is 0 or 1");
+
+    static constexpr bit_order order = Order;
+    static constexpr unsigned root_bits = RootBits;
+    static constexpr unsigned max_bits = MaxBits;
+    static constexpr unsigned early_change = EarlyChange;
+    static constexpr bool has_clear = HasClear;
+    static constexpr bool has_end = HasEnd;
+    static constexpr bool group_padding = GroupPadding;
+
+    static constexpr uint32_t clear_code = 1u << RootBits;
+    static constexpr uint32_t end_code = clear_code + 1;
+    static constexpr uint32_t first_code = clear_code + HasClear + HasEnd;
+    static constexpr uint32_t table_size = 1u << MaxBits;
+};
+
+// TIFF: MSB-first, 9-12 bits, widens one code early.
+using tiff = variant<bit_order::msb_first, 8, 12, 1, true, true, false>;
+
+// PDF LZWDecode with its EarlyChange parameter; EarlyChange 1 is TIFF.
+template <unsigned EarlyChange>
+using pdf = variant<bit_order::msb_first, 8, 12, EarlyChange, true, true, false>;
+
+// GIF: LSB-first with the image's minimum code size as root.
+template <unsigned RootBits>
+using gif = variant<bit_order::lsb_first, RootBits, 12, 0, true, true, false>;
+
+// Unix compress (.Z) code stream: no END code, CLEAR only in block mode.
+template <unsigned MaxBits, bool BlockMode>
+using compress = variant<bit_order::lsb_first, 8, MaxBits, 0, BlockMode, false, true>;
+
+// 64-bit bit buffer, refilled with one 8-byte load away from the end of the
+// input and byte by byte near it, never reading past in + in_size.
+template <bit_order Order>
+class bit_reader
+{
+  public:
+    bit_reader(const uint8_t *in, size_t in_size) : p(in), end(in + in_size)
+    {
+    }
+
+    // Makes at least width bits available; false once the input runs out.
+    bool fill(unsigned width)
+    {
+        if (available >= width)
+        {
+            return true;
+        }
+
+        if (end - p >= 8)
+        {
+            uint64_t value;
+            std::memcpy(&value, p, sizeof(value));
+            if constexpr ((Order == bit_order::msb_first) == (std::endian::native == std::endian::little))
+            {
+                value = __builtin_bswap64(value);
+            }
+
+            // Bytes that do not fit whole are loaded again by the next refill,
+            // into the same bit positions.
+            if constexpr (Order == bit_order::msb_first)
+            {
+                buffer |= value >> available;
+            }
+            else
+            {
+                buffer |= value << available;
+            }
+            p += (63 - available) >> 3;
+            available |= 56;
+            return true;
+        }
+
+        while (available <= 56 && p < end)
+        {
+            if constexpr (Order == bit_order::msb_first)
+            {
+                buffer |= uint64_t{*p++} << (56 - available);
+            }
+            else
+            {
+                buffer |= uint64_t{*p++} << available;
+            }
+            available += 8;
+        }
+
+        return available >= width;
+    }
+
+    uint32_t take(unsigned width)
+    {
+        uint32_t code;
+        if constexpr (Order == bit_order::msb_first)
+        {
+            code = static_cast<uint32_t>(buffer >> (64 - width));
+            buffer <<= width;
+        }
+        else
+        {
+            code = static_cast<uint32_t>(buffer) & ((1u << width) - 1);
+            buffer >>= width;
+        }
+        available -= width;
+        return code;
+    }
+
+  private:
+    const uint8_t *p;
+    const uint8_t *end;
+    uint64_t buffer = 0;
+    unsigned available = 0;
+};
+
+// The dictionary holds, for every code, the offset of an earlier occurrence of
+// its string in the output and its length, so emitting a code is one copy.
+// Reusable across calls; 16-bit variants need 512 KB, allocate those on the
+// heap.
+template <class V>
+class decoder
+{
+  public:
+    size_t decode(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size)
+    {
+        if (in == nullptr && in_size != 0)
+        {
+            return -1;
+        }
+        if (out == nullptr)
+        {
+            out_size = 0;
+        }
+        if (out_size > UINT32_MAX)
+        {
+            out_size = UINT32_MAX;
+        }
+
+        bit_reader<V::order> r(in, in_size);
+        uint8_t *w = out;
+        uint8_t *out_end = out + out_size;
+
+        unsigned width = V::root_bits + 1;
+        uint32_t next_code = V::first_code;
+        uint32_t previous_offset = 0;
+        uint32_t previous_length = 0; // 0 right after CLEAR
+        unsigned group_codes = 0;
+
+        auto skip_group = [&](unsigned group_width) {
+            if constexpr (V::group_padding)
+            {
+                for (; group_codes % 8 != 0; group_codes++)
+                {
+                    if (!r.fill(group_width))
+                    {
+                        break;
+                    }
+                    r.take(group_width);
+                }
+                group_codes = 0;
+            }
+        };
+
+        while (r.fill(width))
+        {
+            uint32_t code = r.take(width);
+            if constexpr (V::group_padding)
+            {
+                group_codes++;
+            }
+
+            uint32_t length;
+            if (code < V::clear_code)
+            {
+                if (w == out_end)
+                {
+                    return -1;
+                }
+                *w = static_cast<uint8_t>(code);
+                length = 1;
+            }
+            else if (V::has_clear && code == V::clear_code)
+            {
+                skip_group(width);
+                width = V::root_bits + 1;
+                next_code = V::first_code;
+                previous_length = 0;
+                continue;
+            }
+            else if (V::has_end && code == V::end_code)
+            {
+                break;
+            }
+            else if (code < next_code)
+            {
+                length = lengths[code];
+                if (length > static_cast<size_t>(out_end - w))
+                {
+                    return -1;
+                }
+                std::memcpy(w, out + offsets[code], length);
+            }
+            else if (code == next_code && previous_length != 0)
+            {
+                // KwKwK: previous string followed by its own first byte
+                length = previous_length + 1;
+                if (length > static_cast<size_t>(out_end - w))
+                {
+                    return -1;
+                }
+                std::memcpy(w, out + previous_offset, previous_length);
+                w[previous_length] = out[previous_offset];
+            }
+            else
+            {
+                return -1;
+            }
+
+            if (previous_length != 0 && next_code < V::table_size)
+            {
+                offsets[next_code] = previous_offset;
+                lengths[next_code] = previous_length + 1;
+                next_code++;
+
+                if (next_code + V::early_change == 1u << width && width < V::max_bits)
+                {
+                    skip_group(width);
+                    width++;
+                }
+            }
+
+            previous_offset = static_cast<uint32_t>(w - out);
+            previous_length = length;
+            w += length;
+        }
+
+        return w - out;
+    }
+
+  private:
+    uint32_t offsets[V::table_size];
+    uint32_t lengths[V::table_size];
+};
+
+template <class V>
+size_t decode(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size)
+{
+    if constexpr (V::max_bits <= 12)
+    {
+        decoder<V> d;
+        return d.decode(in, in_size, out, out_size);
+    }
+    else
+    {
+        auto d = std::make_unique<decoder<V>>();
+        return d->decode(in, in_size, out, out_size);
+    }
+}
+
+// Runtime parameters mapped onto the specializations.
+
+inline size_t decode_pdf(bool early_change, const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size)
+{
+    return early_change ? decode<pdf<1>>(in, in_size, out, out_size) : decode<pdf<0>>(in, in_size, out, out_size);
+}
+
+// min_code_size is the byte before the image data; in is the LZW stream with
+// the sub-block length bytes already removed.
+template <unsigned RootBits = 2>
+size_t decode_gif(unsigned min_code_size, const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size)
+{
+    if (min_code_size == RootBits)
+    {
+        return decode<gif<RootBits>>(in, in_size, out, out_size);
+    }
+    if constexpr (RootBits < 8)
+    {
+        return decode_gif<RootBits + 1>(min_code_size, in, in_size, out, out_size);
+    }
+    return -1;
+}
+
+template <unsigned MaxBits = 9>
+size_t decode_compress_bits(unsigned max_bits, bool block_mode, const uint8_t *in, size_t in_size, uint8_t *out,
+                            size_t out_size)
+{
+    if (max_bits == MaxBits)
+    {
+        return block_mode ? decode<compress<MaxBits, true>>(in, in_size, out, out_size)
+                          : decode<compress<MaxBits, false>>(in, in_size, out, out_size);
+    }
+    if constexpr (MaxBits < 16)
+    {
+        return decode_compress_bits<MaxBits + 1>(max_bits, block_mode, in, in_size, out, out_size);
+    }
+    return -1;
+}
+
+// A whole .Z file: 0x1F 0x9D, then max bits and the block mode flag (0x80).
+inline size_t decode_compress(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size)
+{
+    if (in == nullptr || in_size < 3 || in[0] != 0x1F || in[1] != 0x9D || (in[2] & 0x60) != 0)
+    {
+        return -1;
+    }
+
+    return decode_compress_bits(in[2] & 0x1F, (in[2] & 0x80) != 0, in + 3, in_size - 3, out, out_size);
+}
+
+} // namespace lzw
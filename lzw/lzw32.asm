@@ -1,11 +1,7 @@
         section .text
 
+        global lzw_decode
         global is_power_of_two
-        global decode_table_init
-        global decode_table_contains
-        global decode_table_append
-        global decode_table_get_first_byte
-        global decode_table_write_bytes
         global reader_init
         global reader_next
         global reader_has_next
@@ -20,135 +16,249 @@ is_power_of_two:
         movzx eax, al
         ret
 
-; void decode_table_init(struct decode_table *table)
-; struct decode_table layout:
-;   offset 0: uint32_t entries[4096] (16384 bytes)
-;   offset 16384: int16_t next_code (2 bytes)
-decode_table_init:
-        mov edx, [esp+4]               ; edx = table
-
-        ; Initialize first 256 entries with ENTRY_PACK(0, 0, 1)
-        ; ENTRY_PACK(0, 0, 1) = (0 & 0xFFF) | ((0 & 0xFF) << 12) | ((1 & 0x1) << 20)
-        ;                     = 0x00100000
-        mov eax, 0x00100000
-        mov ecx, 256
-        mov edi, edx
-.loop1:
-        mov [edi], eax
-        add edi, 4
-        dec ecx
-        jnz .loop1
-
-        ; Initialize remaining entries (256 to 4095) with 0
+; size_t lzw_decode(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+;
+; The whole decode.c loop with the reader, decode_table and
+; decode_table_write_bytes inlined. Never reads past in + in_size and never
+; writes past out + out_size; the output bound is checked once per string.
+;
+; Stack frame:
+;   offset 0: struct decode_table entries (4096 * 8 bytes, see decode_table.c)
+;     low dword:  previous_code (bits 0-11), byte (bits 12-19)
+;     high dword: length (bits 0-15), first_byte (bits 16-23)
+;     codes below next_code are valid, CLEAR_CODE only rewinds next_code
+;   above it: locals, 4 saved registers, return address, arguments
+
+%define TABLE_SIZE 4096 * 8
+%define LOCALS_SIZE 32
+%define FRAME_SIZE TABLE_SIZE + LOCALS_SIZE
+
+%define bits_available esp + TABLE_SIZE + 0
+%define bits_count esp + TABLE_SIZE + 4
+%define previous_code esp + TABLE_SIZE + 8
+%define code esp + TABLE_SIZE + 12
+%define string_length esp + TABLE_SIZE + 16
+%define first_byte esp + TABLE_SIZE + 20
+%define in_end esp + TABLE_SIZE + 24
+%define out_end esp + TABLE_SIZE + 28
+
+%define arg_in esp + FRAME_SIZE + 20
+%define arg_in_size esp + FRAME_SIZE + 24
+%define arg_out esp + FRAME_SIZE + 28
+%define arg_out_size esp + FRAME_SIZE + 32
+
+lzw_decode:
+        mov eax, [esp+4]               ; eax = in
+        test eax, eax
+        jz .error_no_frame
+        mov eax, [esp+12]              ; eax = out
+        test eax, eax
+        jnz .start
+        cmp dword [esp+8], 0           ; out == NULL is fine for empty input
+        jne .error_no_frame
         xor eax, eax
-        mov ecx, 4096 - 256
-.loop2:
-        mov [edi], eax
-        add edi, 4
-        dec ecx
-        jnz .loop2
-
-        ; Set next_code = FIRST_CODE (258)
-        mov word [edx+16384], 258
-
-        ret
-
-; bool decode_table_contains(struct decode_table const *table, uint16_t code)
-decode_table_contains:
-        mov edx, [esp+4]               ; edx = table
-        movzx eax, word [esp+8]        ; eax = code
-        mov eax, [edx+eax*4]           ; eax = table->entries[code]
-        shr eax, 20                    ; eax >>= 20 (extract has_value bit)
-        and eax, 1                     ; eax &= 1
         ret
 
-; void decode_table_append(struct decode_table *table, int16_t code, uint8_t byte)
-decode_table_append:
-        mov edx, [esp+4]               ; edx = table
-        movsx eax, word [esp+8]        ; eax = code (sign-extended)
-        movzx ecx, byte [esp+12]       ; ecx = byte
-
-        ; ENTRY_PACK(code, byte, 1) = (code & 0xFFF) | ((byte & 0xFF) << 12) | (1 << 20)
-        and eax, 0xFFF                 ; eax = code & 0xFFF
-        shl ecx, 12                    ; ecx = byte << 12
-        or eax, ecx                    ; eax |= ecx
-        or eax, 0x00100000             ; eax |= (1 << 20)
-
-        ; table->entries[table->next_code] = packed_entry
-        movzx ecx, word [edx+16384]    ; ecx = table->next_code
-        mov [edx+ecx*4], eax           ; table->entries[next_code] = eax
-
-        ; ++table->next_code
-        inc word [edx+16384]
-
+.error_no_frame:
+        mov eax, -1
         ret
 
-; uint8_t decode_table_get_first_byte(struct decode_table const *table, uint16_t code)
-decode_table_get_first_byte:
-        mov edx, [esp+4]               ; edx = table
-        movzx eax, word [esp+8]        ; eax = code
-
-.loop:
-        cmp eax, 258                   ; FIRST_CODE = 258
-        jb .done
-
-        mov ecx, [edx+eax*4]           ; ecx = table->entries[code]
-        and ecx, 0xFFF                 ; ecx = ENTRY_GET_PREVIOUS_CODE(entry)
-        mov eax, ecx                   ; code = ecx
-        jmp .loop
-
-.done:
-        ret
-
-; uint16_t decode_table_write_bytes(uint8_t *w, uint16_t code, struct decode_table const *table)
-decode_table_write_bytes:
+.start:
+        push ebp
         push ebx
         push esi
         push edi
+        sub esp, FRAME_SIZE
+
+        ; Register usage in the loop:
+        ;   ebx = bit buffer (MSB first), esi = next input byte
+        ;   edi = w, ebp = next_code, esp = table
+        xor ebx, ebx
+        mov dword [bits_available], 0
+        mov esi, [arg_in]
+        mov eax, [arg_in_size]
+        add eax, esi
+        mov [in_end], eax
+        mov edi, [arg_out]
+        mov eax, [arg_out_size]
+        add eax, edi
+        mov [out_end], eax
+
+        ; Literal entries: ENTRY_PACK(0, i, 1, i)
+        xor ecx, ecx
+.init_literal:
+        mov eax, ecx
+        shl eax, 12
+        mov [esp+ecx*8], eax
+        mov eax, ecx
+        shl eax, 16
+        or eax, 1
+        mov [esp+ecx*8+4], eax
+        inc ecx
+        cmp ecx, 256
+        jb .init_literal
+
+.clear:
+        ; decode_table_reset
+        mov ebp, 258                   ; next_code = FIRST_CODE
+        mov dword [bits_count], 9
+        mov dword [previous_code], 256 ; previous_code = CLEAR_CODE
+
+.next_code:
+        mov ecx, [bits_count]
+        cmp [bits_available], ecx
+        jb .refill
+
+.read:
+        ; reader_next: take bits_count bits from the top of the buffer
+        mov eax, ebx
+        mov ecx, [bits_count]
+        shl ebx, cl
+        sub [bits_available], ecx
+        neg ecx                        ; cl & 31 = 32 - bits_count
+        shr eax, cl                    ; eax = code
+        mov [code], eax
+
+        cmp eax, 256                   ; CLEAR_CODE
+        je .clear
+        cmp eax, 257                   ; END_OF_INFORMATION
+        je .done
+        cmp dword [previous_code], 256
+        je .first_after_clear
+
+        cmp eax, ebp                   ; decode_table_contains: code < next_code
+        ja .error
+        je .not_in_table
+        xor edx, edx                   ; string of code, nothing appended
+        jmp .emit
+
+.not_in_table:
+        ; KwKwK: previous string followed by its own first byte
+        mov eax, [previous_code]
+        mov edx, 1
+
+.emit:
+        ; eax = handled code, edx = 1 if its first byte is appended
+        movzx ecx, word [esp+eax*8+4]  ; ecx = length of the handled string
+        add edx, ecx
+        mov [string_length], edx
+        add edx, edi
+        cmp edx, [out_end]
+        ja .error                      ; does not fit in out_size
+
+        movzx edx, byte [esp+eax*8+6]  ; edx = first byte of the handled string
+        mov [first_byte], edx
+        cmp [string_length], ecx
+        je .write
+        mov [edi+ecx], dl              ; KwKwK: trailing first byte
+
+.write:
+        ; decode_table_write_bytes: backwards from w + length
+        add ecx, edi                   ; ecx = end
+.write_loop:
+        mov edx, [esp+eax*8]           ; edx = low dword of table->entries[code]
+        dec ecx
+        mov eax, edx
+        shr edx, 12
+        mov [ecx], dl                  ; *--end = ENTRY_GET_BYTE(entry)
+        and eax, 0xFFF                 ; code = ENTRY_GET_PREVIOUS_CODE(entry)
+        cmp ecx, edi
+        jne .write_loop
+
+        ; decode_table_append(previous_code, first_byte)
+        cmp ebp, 4096
+        jae .appended                  ; table is full
+        mov eax, [previous_code]
+        mov edx, [esp+eax*8+4]         ; length and first byte of previous string
+        inc edx
+        mov [esp+ebp*8+4], edx
+        mov edx, [first_byte]
+        shl edx, 12
+        or edx, eax
+        mov [esp+ebp*8], edx
+        inc ebp
+
+        ; Grow the code width when next_code + 1 becomes a power of two
+        lea eax, [ebp+1]
+        test eax, ebp
+        jnz .appended
+        cmp dword [bits_count], 12     ; MAX_BITS_COUNT
+        jae .appended
+        inc dword [bits_count]
+
+.appended:
+        add edi, [string_length]
+        mov eax, [code]
+        mov [previous_code], eax
+        jmp .next_code
+
+.first_after_clear:
+        ; Only a literal can follow CLEAR_CODE
+        cmp eax, 256
+        jae .error
+        cmp edi, [out_end]
+        jae .error
+        mov [edi], al
+        inc edi
+        mov [previous_code], eax
+        jmp .next_code
+
+.refill:
+        ; Fewer than bits_count bits buffered
+        lea eax, [esi+4]
+        cmp eax, [in_end]
+        ja .refill_tail
+
+        ; Load 4 bytes and keep the whole ones that fit
+        mov eax, [esi]
+        bswap eax
+        mov ecx, [bits_available]
+        shr eax, cl
+        or ebx, eax
+        mov eax, 31
+        sub eax, ecx
+        shr eax, 3
+        add esi, eax
+        or dword [bits_available], 24
+        jmp .read
+
+.refill_tail:
+        ; Last bytes of the input: one at a time, never past in + in_size
+        mov edx, [bits_available]
+.tail_loop:
+        cmp edx, 24
+        ja .tail_done
+        cmp esi, [in_end]
+        jae .tail_done
+        movzx eax, byte [esi]
+        inc esi
+        mov ecx, 24
+        sub ecx, edx
+        shl eax, cl
+        or ebx, eax
+        add edx, 8
+        jmp .tail_loop
+
+.tail_done:
+        mov [bits_available], edx
+        cmp edx, [bits_count]
+        jb .done                       ; reader_has_next is false
+        jmp .read
 
-        mov esi, [esp+16]              ; esi = w
-        movzx edi, word [esp+20]       ; edi = code
-        mov ebx, [esp+24]              ; ebx = table
-
-        cmp edi, 258                   ; FIRST_CODE = 258
-        jae .recursive
-
-        ; Base case: code < FIRST_CODE
-        mov eax, edi                   ; eax = code
-        mov byte [esi], al             ; *w = code (low byte)
-        mov eax, 1                     ; return 1
-        pop edi
-        pop esi
-        pop ebx
-        ret
-
-.recursive:
-        ; uint32_t entry = table->entries[code]
-        mov eax, [ebx+edi*4]           ; eax = table->entries[code]
-
-        ; ENTRY_GET_PREVIOUS_CODE(entry)
-        and eax, 0xFFF                 ; eax = previous_code
-
-        ; Recursive call: decode_table_write_bytes(w, previous_code, table)
-        push ebx                       ; Push table
-        push eax                       ; Push previous_code (already in eax)
-        push esi                       ; Push w
-        call decode_table_write_bytes
-        add esp, 12                    ; Clean up stack
-
-        ; eax now contains bytes returned from recursion
-        ; w[bytes] = ENTRY_GET_BYTE(entry)
-        mov ecx, [ebx+edi*4]           ; ecx = table->entries[code]
-        shr ecx, 12                    ; ecx >>= 12
-        and ecx, 0xFF                  ; ecx &= 0xFF (extract byte)
-        mov [esi+eax], cl              ; w[bytes] = cl
+.done:
+        mov eax, edi
+        sub eax, [arg_out]             ; return w - out
+        jmp .exit
 
-        ; return bytes + 1
-        inc eax
+.error:
+        mov eax, -1
 
+.exit:
+        add esp, FRAME_SIZE
         pop edi
         pop esi
         pop ebx
+        pop ebp
         ret
 
 ; void reader_init(struct reader *r, uint8_t const *data, size_t size)
@@ -156,7 +266,8 @@ decode_table_write_bytes:
 ;   offset 0: uint8_t const *data (4 bytes)
 ;   offset 4: size_t size (4 bytes)
 ;   offset 8: size_t byte_index (4 bytes)
-;   offset 12: uint8_t bit_index (1 byte)
+;   offset 12: uint64_t buffer (8 bytes, low dword first)
+;   offset 20: uint8_t bits_available (1 byte)
 reader_init:
         mov eax, [esp+4]               ; eax = r (pointer to struct reader)
         mov edx, [esp+8]               ; edx = data
@@ -165,49 +276,131 @@ reader_init:
         mov [eax], edx                 ; r->data = data
         mov [eax+4], ecx               ; r->size = size
         mov dword [eax+8], 0           ; r->byte_index = 0
-        mov byte [eax+12], 0           ; r->bit_index = 0
+        mov dword [eax+12], 0          ; r->buffer = 0
+        mov dword [eax+16], 0
+        mov byte [eax+20], 0           ; r->bits_available = 0
 
         ret
 
+; Refills r->buffer, called with edx = r and r->bits_available < 32.
+; Clobbers eax and ecx.
+reader_refill:
+        push ebx
+        push esi
+
+        mov eax, [edx+8]               ; eax = r->byte_index
+        lea ecx, [eax+8]
+        cmp ecx, [edx+4]
+        ja .tail                       ; fewer than 8 bytes left
+
+        ; Load 8 bytes big-endian and keep the whole ones that fit
+        mov esi, [edx]                 ; esi = r->data
+        mov ebx, [esi+eax]
+        mov esi, [esi+eax+4]
+        bswap ebx                      ; ebx = high dword
+        bswap esi                      ; esi = low dword
+        movzx ecx, byte [edx+20]       ; ecx = r->bits_available
+        shrd esi, ebx, cl              ; 64-bit shift right by bits_available
+        shr ebx, cl
+        or [edx+12], esi               ; r->buffer |= loaded >> bits_available
+        or [edx+16], ebx
+        mov eax, 63
+        sub eax, ecx
+        shr eax, 3
+        add [edx+8], eax               ; r->byte_index += (63 - bits_available) / 8
+        or byte [edx+20], 56           ; r->bits_available |= 56
+
+        pop esi
+        pop ebx
+        ret
+
+.tail:
+        ; Last bytes of the input: one byte at a time, never past r->size
+        movzx ecx, byte [edx+20]       ; ecx = r->bits_available
+.tail_loop:
+        cmp ecx, 56
+        ja .tail_done
+        mov eax, [edx+8]
+        cmp eax, [edx+4]
+        jae .tail_done
+        mov esi, [edx]
+        movzx ebx, byte [esi+eax]      ; ebx = r->data[r->byte_index]
+        inc dword [edx+8]              ; ++r->byte_index
+
+        ; r->buffer |= byte << (56 - bits_available)
+        push ecx
+        neg ecx
+        add ecx, 56                    ; ecx = 56 - bits_available
+        cmp ecx, 32
+        jb .shift_low
+        sub ecx, 32
+        shl ebx, cl
+        or [edx+16], ebx
+        jmp .shifted
+.shift_low:
+        xor esi, esi
+        shld esi, ebx, cl
+        shl ebx, cl
+        or [edx+12], ebx
+        or [edx+16], esi
+.shifted:
+        pop ecx
+        add ecx, 8                     ; bits_available += 8
+        jmp .tail_loop
+
+.tail_done:
+        mov [edx+20], cl
+
+        pop esi
+        pop ebx
+        ret
+
 ; uint16_t reader_next(struct reader *r, uint8_t bits_count)
 reader_next:
         push ebx
-        mov edx, [esp+8]               ; edx = r
-        mov eax, [edx]                 ; eax = r->data
-        add eax, [edx+8]               ; eax += r->byte_index
-        mov ebx, [eax]                 ; Load 4 bytes
-        bswap ebx                      ; Convert to big-endian
-        movzx ecx, byte [edx+12]       ; ecx = r->bit_index
-        shl ebx, cl                    ; Shift left by bit_index
-        mov cl, [esp+12]               ; cl = bits_count
-        mov eax, 32
-        sub eax, ecx                   ; eax = 32 - bits_count
-        mov cl, al
-        shr ebx, cl                    ; Extract bits from top
-
-        mov cl, [esp+12]               ; cl = bits_count
-        add cl, [edx+12]               ; cl += r->bit_index
-        movzx eax, cl
-        shr eax, 3                     ; eax /= 8
-        add [edx+8], eax               ; r->byte_index += eax
-        and cl, 7                      ; cl %= 8
-        mov [edx+12], cl               ; r->bit_index = cl
-
-        movzx eax, bx                  ; Return uint16_t value
+        push esi
+        mov edx, [esp+12]              ; edx = r
+        movzx ebx, byte [esp+16]       ; ebx = bits_count
+
+        cmp [edx+20], bl
+        jae .ready
+        call reader_refill
+
+.ready:
+        ; result = r->buffer >> (64 - bits_count), all in the high dword
+        mov eax, [edx+16]
+        mov ecx, 32
+        sub ecx, ebx
+        shr eax, cl
+
+        ; r->buffer <<= bits_count
+        mov ecx, ebx
+        mov esi, [edx+12]
+        shld [edx+16], esi, cl
+        shl esi, cl
+        mov [edx+12], esi
+        sub [edx+20], bl               ; r->bits_available -= bits_count
+
+        movzx eax, ax                  ; Return uint16_t value
+        pop esi
         pop ebx
         ret
 
-; bool reader_has_next(struct reader const *r, uint8_t bits_count)
+; bool reader_has_next(struct reader *r, uint8_t bits_count)
 reader_has_next:
         mov edx, [esp+4]               ; edx = r (pointer to struct reader)
-        movzx eax, byte [esp+8]        ; eax = bits_count
+        movzx ecx, byte [esp+8]        ; ecx = bits_count
 
-        add al, [edx+12]               ; al = r->bit_index + bits_count
-        add eax, 7                     ; eax = r->bit_index + bits_count + 7
-        shr eax, 3                     ; eax = (r->bit_index + bits_count + 7) / 8
-        add eax, [edx+8]               ; eax = r->byte_index + result
+        cmp [edx+20], cl
+        jae .yes
+        call reader_refill
 
-        cmp eax, [edx+4]               ; Compare with r->size
-        setle al
+        movzx ecx, byte [esp+8]
+        cmp [edx+20], cl
+        setae al
         movzx eax, al
         ret
+
+.yes:
+        mov eax, 1
+        ret
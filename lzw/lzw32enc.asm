@@ -0,0 +1,208 @@
+        section .text
+
+        global lzw_encode
+
+; size_t lzw_encode(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+;
+; Same output as encode.c. The (prefix, byte) -> code hash lives on the stack,
+; 8192 dwords of key << 12 | code with key = prefix << 8 | byte, probed
+; linearly; a slot matches when xor with the shifted key leaves only code bits.
+
+%define HASH_SIZE 8192 * 4
+%define LOCALS_SIZE 24
+%define FRAME_SIZE HASH_SIZE + LOCALS_SIZE
+
+; locals, above the hash
+%define in_end esp + HASH_SIZE + 0
+%define out_end esp + HASH_SIZE + 4
+%define buffer esp + HASH_SIZE + 8     ; pending bits in the low bits
+%define pending esp + HASH_SIZE + 12   ; number of pending bits, below 8
+%define bits_count esp + HASH_SIZE + 16
+%define next_byte esp + HASH_SIZE + 20 ; byte that starts the next prefix
+
+; arguments, above the locals, 4 saved registers and the return address
+%define arg_in esp + FRAME_SIZE + 20
+%define arg_in_size esp + FRAME_SIZE + 24
+%define arg_out esp + FRAME_SIZE + 28
+%define arg_out_size esp + FRAME_SIZE + 32
+
+; Appends the code in eax to the output and writes the whole bytes.
+; Clobbers eax, ecx and edx.
+%macro PUT_CODE 0
+        mov ecx, [bits_count]
+        mov edx, [buffer]
+        shl edx, cl
+        or edx, eax
+        add ecx, [pending]
+%%flush:
+        cmp ecx, 8
+        jb %%done
+        cmp edi, [out_end]
+        jae .error
+        sub ecx, 8
+        mov eax, edx
+        shr eax, cl
+        mov [edi], al
+        inc edi
+        jmp %%flush
+%%done:
+        mov [buffer], edx
+        mov [pending], ecx
+%endmacro
+
+; Zeroes the hash. Clobbers eax and ecx.
+%macro CLEAR_HASH 0
+        push edi
+        lea edi, [esp+4]
+        xor eax, eax
+        mov ecx, 8192
+        rep stosd
+        pop edi
+%endmacro
+
+lzw_encode:
+        mov eax, [esp+12]              ; eax = out
+        test eax, eax
+        jz .error_no_frame
+        mov eax, [esp+4]               ; eax = in
+        test eax, eax
+        jnz .start
+        cmp dword [esp+8], 0           ; in == NULL is fine for empty input
+        je .start
+
+.error_no_frame:
+        mov eax, -1
+        ret
+
+.start:
+        push ebp
+        push ebx
+        push esi
+        push edi
+        sub esp, FRAME_SIZE
+
+        ; Register usage in the loop:
+        ;   esi = r, edi = w
+        ;   ebx = code of the current prefix, ebp = next_code
+        mov esi, [arg_in]
+        mov eax, [arg_in_size]
+        add eax, esi
+        mov [in_end], eax
+        mov edi, [arg_out]
+        mov eax, [arg_out_size]
+        add eax, edi
+        mov [out_end], eax
+        mov dword [buffer], 0
+        mov dword [pending], 0
+        mov dword [bits_count], 9
+        mov ebp, 258                   ; next_code = FIRST_CODE
+        CLEAR_HASH
+
+        mov eax, 256                   ; CLEAR_CODE
+        PUT_CODE
+
+        cmp esi, [in_end]
+        je .end_of_information
+        movzx ebx, byte [esi]
+        inc esi
+
+.next_byte:
+        cmp esi, [in_end]
+        jae .last_code
+        movzx edx, byte [esi]
+        inc esi
+
+        ; Look up prefix + byte
+        mov eax, ebx
+        shl eax, 8
+        or eax, edx
+        shl eax, 12                    ; eax = key << 12
+        imul ecx, eax, 0x9E3779B1
+        shr ecx, 19                    ; ecx = hash index of key << 12
+
+.probe:
+        mov edx, [esp+ecx*4]
+        test edx, edx
+        jz .miss
+        xor edx, eax
+        cmp edx, 0xFFF
+        jbe .hit                       ; same key, edx = code
+        inc ecx
+        and ecx, 8191
+        jmp .probe
+
+.hit:
+        mov ebx, edx
+        jmp .next_byte
+
+.last_code:
+        mov dword [next_byte], -1      ; end after emitting the prefix
+        jmp .emit
+
+.miss:
+        mov edx, eax
+        shr edx, 12
+        and edx, 0xFF
+        mov [next_byte], edx
+        or eax, ebp
+        mov [esp+ecx*4], eax
+
+.emit:
+        mov eax, ebx
+        PUT_CODE
+
+        ; The decoder adds an entry for every code but the first after
+        ; CLEAR_CODE, so the width follows the same schedule for the last code
+        inc ebp
+        cmp ebp, 4094                  ; keep the decoder's table below 4094
+        je .clear
+        lea eax, [ebp-1]
+        test eax, ebp
+        jnz .advance                   ; next_code is not a power of two
+        cmp dword [bits_count], 12     ; MAX_BITS_COUNT
+        jae .advance
+        inc dword [bits_count]
+        jmp .advance
+
+.clear:
+        mov eax, 256                   ; CLEAR_CODE
+        PUT_CODE
+        CLEAR_HASH
+        mov ebp, 258                   ; next_code = FIRST_CODE
+        mov dword [bits_count], 9
+
+.advance:
+        mov ebx, [next_byte]
+        test ebx, ebx
+        jns .next_byte
+
+.end_of_information:
+        mov eax, 257                   ; END_OF_INFORMATION
+        PUT_CODE
+        mov ecx, [pending]
+        test ecx, ecx
+        jz .done
+        cmp edi, [out_end]
+        jae .error
+        neg ecx
+        add ecx, 8
+        mov eax, [buffer]
+        shl eax, cl
+        mov [edi], al
+        inc edi
+
+.done:
+        mov eax, edi
+        sub eax, [arg_out]             ; return w - out
+        jmp .exit
+
+.error:
+        mov eax, -1
+
+.exit:
+        add esp, FRAME_SIZE
+        pop edi
+        pop esi
+        pop ebx
+        pop ebp
+        ret
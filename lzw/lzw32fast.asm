@@ -0,0 +1,204 @@
+        section .text
+
+        global lzw_decode_fast
+
+; Faster lzw_decode variant with relaxed requirements (see decode.h):
+;   - the input must be a valid TIFF LZW stream, codes are not validated;
+;   - up to LZW_FAST_IN_SLACK (4) bytes past in + in_size are read;
+;   - up to LZW_FAST_OUT_SLACK (16) bytes past out + out_size may be written;
+;   - in_size must be below 512 MB, the reader keeps a 32-bit bit position.
+;
+; The dictionary stores, for every code, a pointer to an earlier occurrence of
+; its string in the output and the string length, so emitting a code is a
+; single forward copy done in 4, 8 or 16-byte chunks. The last chunk may run
+; past the end of the string; those bytes are overwritten by the next string
+; or land in the slack region.
+
+%define TABLE_SIZE 4096 * 8            ; entries: dword pointer, dword length
+%define LOCALS_SIZE 16
+%define FRAME_SIZE TABLE_SIZE + LOCALS_SIZE
+
+; locals, above the table
+%define in_bits esp + TABLE_SIZE + 0   ; in_size * 8
+%define bits_count esp + TABLE_SIZE + 4
+%define prev_ptr esp + TABLE_SIZE + 8  ; previous string in the output
+%define prev_len esp + TABLE_SIZE + 12 ; 0 right after CLEAR_CODE
+
+; arguments, above the locals, 4 saved registers and the return address
+%define arg_in esp + FRAME_SIZE + 20
+%define arg_in_size esp + FRAME_SIZE + 24
+%define arg_out esp + FRAME_SIZE + 28
+%define arg_out_size esp + FRAME_SIZE + 32
+
+; Copies ecx bytes from edx to edi in chunks, may write up to 15 extra bytes.
+; Clobbers eax and xmm0.
+%macro COPY_STRING 0
+        cmp ecx, 4
+        ja %%copy8
+        mov eax, [edx]
+        mov [edi], eax
+        jmp %%done
+%%copy8:
+        cmp ecx, 8
+        ja %%copy16
+        movq xmm0, [edx]
+        movq [edi], xmm0
+        jmp %%done
+%%copy16:
+        xor eax, eax
+%%loop:
+        movdqu xmm0, [edx+eax]
+        movdqu [edi+eax], xmm0
+        add eax, 16
+        cmp eax, ecx
+        jb %%loop
+%%done:
+%endmacro
+
+; size_t lzw_decode_fast(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+lzw_decode_fast:
+        mov eax, [esp+4]               ; eax = in
+        test eax, eax
+        jz .error_no_frame
+        mov eax, [esp+12]              ; eax = out
+        test eax, eax
+        jnz .start
+        cmp dword [esp+8], 0           ; out == NULL is fine for empty input
+        jne .error_no_frame
+        xor eax, eax
+        ret
+
+.error_no_frame:
+        mov eax, -1
+        ret
+
+.start:
+        push ebp
+        push ebx
+        push esi
+        push edi
+        sub esp, FRAME_SIZE
+
+        ; Register usage in the loop:
+        ;   esi = in, ebx = bit position in the input
+        ;   edi = w (write pointer), ebp = next_code
+        mov esi, [arg_in]
+        xor ebx, ebx
+        mov edi, [arg_out]
+        mov ebp, 258                   ; next_code = FIRST_CODE
+
+        mov eax, [arg_in_size]
+        shl eax, 3
+        mov [in_bits], eax
+        mov dword [bits_count], 9
+        mov dword [prev_ptr], 0
+        mov dword [prev_len], 0
+
+        add [arg_out_size], edi        ; arg_out_size now holds out + out_size
+
+.next_code:
+        ; reader_has_next: bit position + bits_count <= in_size * 8
+        mov ecx, [bits_count]
+        lea eax, [ebx+ecx]
+        cmp eax, [in_bits]
+        ja .done
+
+        ; reader_next: one unaligned big-endian load covers bit_index + 12 <= 19 bits
+        mov edx, ebx
+        shr edx, 3
+        mov eax, [esi+edx]
+        bswap eax
+        mov ecx, ebx
+        and ecx, 7
+        shl eax, cl                    ; drop bits already consumed
+        mov ecx, [bits_count]
+        add ebx, ecx                   ; advance bit position
+        neg ecx                        ; cl & 31 = 32 - bits_count
+        shr eax, cl                    ; eax = code
+
+        cmp eax, 256                   ; CLEAR_CODE
+        jb .literal
+        je .clear
+        cmp eax, 257                   ; END_OF_INFORMATION
+        je .done
+        cmp eax, ebp
+        jae .not_in_table
+
+        ; Code is in the table: copy its string from the earlier output
+        mov edx, [esp+eax*8]           ; edx = pointer to the string
+        mov ecx, [esp+eax*8+4]         ; ecx = length
+        lea eax, [edi+ecx]
+        cmp eax, [arg_out_size]
+        ja .error
+        COPY_STRING
+        jmp .emitted
+
+.not_in_table:
+        ; KwKwK: previous string followed by its own first byte
+        mov edx, [prev_ptr]
+        mov ecx, [prev_len]
+        lea eax, [edi+ecx+1]
+        cmp eax, [arg_out_size]
+        ja .error
+        COPY_STRING
+        mov al, [edx]
+        mov [edi+ecx], al
+        inc ecx
+        jmp .emitted
+
+.literal:
+        cmp edi, [arg_out_size]
+        jae .error
+        mov [edi], al
+        mov ecx, 1
+
+.emitted:
+        ; edi = start of the string just written, ecx = its length
+        mov eax, [prev_len]
+        test eax, eax
+        jz .advance                    ; first code after CLEAR_CODE adds nothing
+        cmp ebp, 4096
+        jae .advance                   ; table is full
+
+        ; decode_table_append: previous string plus one byte
+        mov edx, [prev_ptr]
+        inc eax
+        mov [esp+ebp*8], edx
+        mov [esp+ebp*8+4], eax
+        inc ebp
+
+        ; Grow the code width when next_code + 1 becomes a power of two
+        lea eax, [ebp+1]
+        test eax, ebp
+        jnz .advance
+        cmp dword [bits_count], 12     ; MAX_BITS_COUNT
+        jae .advance
+        inc dword [bits_count]
+
+.advance:
+        mov [prev_ptr], edi
+        mov [prev_len], ecx
+        add edi, ecx
+        jmp .next_code
+
+.clear:
+        mov ebp, 258                   ; next_code = FIRST_CODE
+        mov dword [bits_count], 9
+        mov dword [prev_len], 0
+        jmp .next_code
+
+.done:
+        mov eax, edi
+        sub eax, [arg_out]             ; return w - out
+        jmp .exit
+
+.error:
+        mov eax, -1
+
+.exit:
+        add esp, FRAME_SIZE
+        pop edi
+        pop esi
+        pop ebx
+        pop ebp
+        ret
@@ -0,0 +1,238 @@
+        section .text
+
+        global lzw_decode
+
+; size_t lzw_decode(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+;
+; System V AMD64: rdi = in, rsi = in_size, rdx = out, rcx = out_size.
+; Never reads past in + in_size and never writes past out + out_size.
+;
+; The dictionary lives on the stack: for every code a dword offset of an
+; earlier occurrence of its string in the output and a dword length, so the
+; output may not exceed 4 GB. Emitting a code copies that occurrence forward,
+; in 8 or 16-byte chunks while the whole rounded-up chunk fits in the output
+; and byte by byte near its end. Input bits come from a 64-bit buffer kept in
+; a register and refilled with one 8-byte load every few codes.
+
+%define TABLE_SIZE 4096 * 8            ; entries: dword offset, dword length
+
+; Copies ecx bytes from rsi to rdi. Clobbers rax and rdx.
+%macro COPY_STRING 0
+        lea rax, [rdi+rcx+15]
+        cmp rax, r11
+        ja %%copy_bytes
+        cmp ecx, 8
+        ja %%copy16
+        mov rax, [rsi]
+        mov [rdi], rax
+        jmp %%done
+%%copy16:
+        xor eax, eax
+%%loop16:
+        movdqu xmm0, [rsi+rax]
+        movdqu [rdi+rax], xmm0
+        add eax, 16
+        cmp eax, ecx
+        jb %%loop16
+        jmp %%done
+%%copy_bytes:
+        xor eax, eax
+%%loop_bytes:
+        mov dl, [rsi+rax]
+        mov [rdi+rax], dl
+        inc eax
+        cmp eax, ecx
+        jb %%loop_bytes
+%%done:
+%endmacro
+
+lzw_decode:
+        test rdi, rdi
+        jz .error_no_frame
+        test rdx, rdx
+        jnz .start
+        test rsi, rsi                  ; out == NULL is fine for empty input
+        jnz .error_no_frame
+        xor eax, eax
+        ret
+
+.error_no_frame:
+        mov rax, -1
+        ret
+
+.start:
+        push rbx
+        push rbp
+        push r12
+        push r13
+        push r14
+        push r15
+        sub rsp, TABLE_SIZE
+
+        ; Register usage in the loop:
+        ;   rbx = next input byte, r9 = in + in_size
+        ;   r15 = bit buffer (MSB first), r8d = bits available in it
+        ;   r10 = out, r11 = out + out_size, rdi = w
+        ;   ebp = next_code, r12d = bits_count
+        ;   r13d = offset of the previous string, r14d = its length (0 after CLEAR_CODE)
+        ;   rsp = table
+        mov rbx, rdi
+        lea r9, [rdi+rsi]
+        xor r15d, r15d
+        xor r8d, r8d
+        mov r10, rdx
+        lea r11, [rdx+rcx]
+        mov rdi, rdx
+        mov ebp, 258                   ; next_code = FIRST_CODE
+        mov r12d, 9
+        xor r13d, r13d
+        xor r14d, r14d
+
+.next_code:
+        cmp r8d, r12d
+        jb .refill
+
+.read:
+        ; reader_next: take bits_count bits from the top of the buffer
+        mov rax, r15
+        mov ecx, r12d
+        shl r15, cl
+        sub r8d, r12d
+        neg ecx                        ; cl & 63 = 64 - bits_count
+        shr rax, cl                    ; eax = code
+
+        cmp eax, 256                   ; CLEAR_CODE
+        jb .literal
+        je .clear
+        cmp eax, 257                   ; END_OF_INFORMATION
+        je .done
+        cmp eax, ebp
+        ja .error
+        je .not_in_table
+
+        ; Code is in the table: copy its string from the earlier output
+        mov esi, [rsp+rax*8]
+        add rsi, r10                   ; rsi = out + offset
+        mov ecx, [rsp+rax*8+4]         ; ecx = length
+        mov rax, r11
+        sub rax, rdi
+        cmp rax, rcx
+        jb .error
+        COPY_STRING
+        jmp .emitted
+
+.not_in_table:
+        ; KwKwK: previous string followed by its own first byte
+        test r14d, r14d
+        jz .error                      ; no previous string right after CLEAR_CODE
+        mov esi, r13d
+        add rsi, r10                   ; rsi = out + previous offset
+        mov ecx, r14d
+        mov rax, r11
+        sub rax, rdi
+        cmp rax, rcx
+        jbe .error
+        COPY_STRING
+        mov al, [rsi]
+        mov [rdi+rcx], al
+        inc ecx
+        jmp .emitted
+
+.literal:
+        cmp rdi, r11
+        jae .error
+        mov [rdi], al
+        mov ecx, 1
+
+.emitted:
+        ; rdi = start of the string just written, ecx = its length
+        test r14d, r14d
+        jz .advance                    ; first code after CLEAR_CODE adds nothing
+        cmp ebp, 4096
+        jae .advance                   ; table is full
+
+        ; decode_table_append: previous string plus one byte
+        lea eax, [r14+1]
+        mov [rsp+rbp*8], r13d
+        mov [rsp+rbp*8+4], eax
+        inc ebp
+
+        ; Grow the code width when next_code + 1 becomes a power of two
+        lea eax, [rbp+1]
+        test eax, ebp
+        jnz .advance
+        cmp r12d, 12                   ; MAX_BITS_COUNT
+        jae .advance
+        inc r12d
+
+.advance:
+        mov r13, rdi
+        sub r13, r10                   ; r13d = offset of this string
+        mov r14d, ecx
+        add rdi, rcx
+        jmp .next_code
+
+.refill:
+        ; Fewer than bits_count bits buffered: refill, about once per 4 codes
+        lea rax, [rbx+8]
+        cmp rax, r9
+        ja .refill_tail
+
+        ; Load 8 bytes and keep the whole ones that fit; the bits below r8d
+        ; are the same bytes the next refill loads again
+        mov rax, [rbx]
+        bswap rax
+        mov ecx, r8d
+        shr rax, cl
+        or r15, rax
+        mov eax, 63
+        sub eax, r8d
+        shr eax, 3
+        add rbx, rax
+        or r8d, 56
+        jmp .read
+
+.refill_tail:
+        ; Last bytes of the input: one at a time, never past in + in_size
+        cmp r8d, 56
+        ja .refilled
+        cmp rbx, r9
+        jae .refilled
+        movzx eax, byte [rbx]
+        inc rbx
+        mov ecx, 56
+        sub ecx, r8d
+        shl rax, cl
+        or r15, rax
+        add r8d, 8
+        jmp .refill_tail
+
+.refilled:
+        ; reader_has_next
+        cmp r8d, r12d
+        jb .done
+        jmp .read
+
+.clear:
+        mov ebp, 258                   ; next_code = FIRST_CODE
+        mov r12d, 9
+        xor r14d, r14d
+        jmp .next_code
+
+.done:
+        mov rax, rdi
+        sub rax, r10                   ; return w - out
+        jmp .exit
+
+.error:
+        mov rax, -1
+
+.exit:
+        add rsp, TABLE_SIZE
+        pop r15
+        pop r14
+        pop r13
+        pop r12
+        pop rbp
+        pop rbx
+        ret
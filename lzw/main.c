@@ -1,13 +1,26 @@
 #include "../minunit/minunit.h"
 
+#include "batch.h"
 #include "common.h"
+#include "context.h"
 #include "decode.h"
+#include "dispatch.h"
+#include "encode.h"
+#include "index.h"
+#include "stats.h"
+#include "stream.h"
+#include "tiff.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+static lzw_decode_fn decode = lzw_decode;
+static size_t in_slack = 0;
+static size_t out_slack = 0;
+
 static void test_base(const char *encoded_path, const char *expected_path)
 {
     FILE *f_encoded = fopen(encoded_path, "rb");
@@ -27,9 +40,9 @@ static void test_base(const char *encoded_path, const char *expected_path)
     mu_assert(encoded_size > 0, "encoded file should not be empty");
     mu_assert(expected_size > 0, "expected file should not be empty");
 
-    uint8_t *encoded = malloc((size_t)encoded_size);
+    uint8_t *encoded = malloc((size_t)encoded_size + in_slack);
     uint8_t *expected = malloc((size_t)expected_size);
-    uint8_t *decoded = malloc((size_t)expected_size * 2);
+    uint8_t *decoded = malloc((size_t)expected_size + out_slack);
 
     mu_assert(encoded != NULL && expected != NULL && decoded != NULL, "memory allocation failed");
 
@@ -42,12 +55,19 @@ static void test_base(const char *encoded_path, const char *expected_path)
     mu_assert(read_encoded == (size_t)encoded_size, "failed to read all encoded data");
     mu_assert(read_expected == (size_t)expected_size, "failed to read all expected data");
 
-    size_t decoded_size = lzw_decode(encoded, (size_t)encoded_size, decoded, (size_t)expected_size * 2);
-    mu_assert(!error(decoded_size), error_message(decoded_size));
+    size_t decoded_size = decode(encoded, (size_t)encoded_size, decoded, (size_t)expected_size);
+    mu_assert(decoded_size != (size_t)-1, "decoding failed");
     mu_assert(decoded_size == (size_t)expected_size, "decoded size mismatch");
 
     mu_assert(memcmp(expected, decoded, (size_t)expected_size) == 0, "decoded content does not match expected");
 
+    // Engines without slack must stop at out_size
+    if (out_slack == 0)
+    {
+        decoded_size = decode(encoded, (size_t)encoded_size, decoded, (size_t)expected_size - 1);
+        mu_assert(decoded_size == (size_t)-1, "decoding into a too small buffer should fail");
+    }
+
     free(encoded);
     free(expected);
     free(decoded);
@@ -111,9 +131,1113 @@ MU_TEST_SUITE(decode_suite)
     MU_RUN_TEST(test_data_1000);
 }
 
-int main(int argc, char *argv[])
+static uint8_t *read_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    uint8_t *data = malloc(file_size > 0 ? (size_t)file_size : 1);
+    if (data != NULL && fread(data, 1, (size_t)file_size, f) != (size_t)file_size)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+
+    *size = (size_t)file_size;
+    return data;
+}
+
+static void test_stream_base(const char *encoded_path, const char *expected_path, size_t chunk_size,
+                             size_t window_size)
+{
+    size_t encoded_size, expected_size;
+    uint8_t *encoded = read_file(encoded_path, &encoded_size);
+    uint8_t *expected = read_file(expected_path, &expected_size);
+    mu_assert(encoded != NULL && expected != NULL, "failed to read test data");
+
+    uint8_t *decoded = malloc(expected_size + window_size);
+    struct lzw_stream *s = malloc(sizeof(*s));
+    mu_assert(decoded != NULL && s != NULL, "memory allocation failed");
+
+    lzw_stream_init(s);
+
+    size_t decoded_size = 0;
+    size_t offset = 0;
+    while (offset < encoded_size)
+    {
+        size_t chunk = encoded_size - offset < chunk_size ? encoded_size - offset : chunk_size;
+        size_t used;
+        size_t written = lzw_stream_feed(s, encoded + offset, chunk, &used, decoded + decoded_size, window_size);
+        mu_assert(!error(written), error_message(written));
+
+        offset += used;
+        decoded_size += written;
+        mu_assert(decoded_size <= expected_size, "decoded more than expected");
+    }
+
+    for (;;)
+    {
+        size_t written = lzw_stream_finish(s, decoded + decoded_size, window_size);
+        mu_assert(!error(written), error_message(written));
+
+        decoded_size += written;
+        mu_assert(decoded_size <= expected_size, "decoded more than expected");
+
+        if (written < window_size)
+        {
+            break;
+        }
+    }
+
+    mu_assert(decoded_size == expected_size, "decoded size mismatch");
+    mu_assert(memcmp(expected, decoded, expected_size) == 0, "decoded content does not match expected");
+
+    free(encoded);
+    free(expected);
+    free(decoded);
+    free(s);
+}
+
+static void test_stream_chunks(const char *encoded_path, const char *expected_path)
+{
+    test_stream_base(encoded_path, expected_path, 1, 1);
+    test_stream_base(encoded_path, expected_path, 1, 4096);
+    test_stream_base(encoded_path, expected_path, 7, 3);
+    test_stream_base(encoded_path, expected_path, 64, 100);
+    test_stream_base(encoded_path, expected_path, 4096, 65536);
+}
+
+MU_TEST(test_stream_aaa)
+{
+    test_stream_chunks("test_data/aaa.enc", "test_data/aaa.dec");
+}
+
+MU_TEST(test_stream_in_out)
+{
+    test_stream_chunks("test_data/in", "test_data/out");
+}
+
+MU_TEST(test_stream_10_1)
+{
+    test_stream_chunks("test_data/10_1.enc", "test_data/10_1.dec");
+}
+
+MU_TEST(test_stream_100_1)
+{
+    test_stream_chunks("test_data/100_1.enc", "test_data/100_1.dec");
+}
+
+MU_TEST(test_stream_1000)
+{
+    test_stream_chunks("test_data/1000.enc", "test_data/1000.dec");
+}
+
+MU_TEST_SUITE(stream_suite)
+{
+    MU_RUN_TEST(test_stream_aaa);
+    MU_RUN_TEST(test_stream_in_out);
+    MU_RUN_TEST(test_stream_10_1);
+    MU_RUN_TEST(test_stream_100_1);
+    MU_RUN_TEST(test_stream_1000);
+}
+
+static void test_encode_base(const char *expected_path, const char *encoded_path)
+{
+    size_t expected_size, encoded_size;
+    uint8_t *expected = read_file(expected_path, &expected_size);
+    uint8_t *encoded = read_file(encoded_path, &encoded_size);
+    mu_assert(expected != NULL && encoded != NULL, "failed to read test data");
+
+    size_t out_size = LZW_ENCODE_BOUND(expected_size);
+    uint8_t *out = malloc(out_size);
+    mu_assert(out != NULL, "memory allocation failed");
+
+    size_t size = lzw_encode(expected, expected_size, out, out_size);
+    mu_assert(size != (size_t)-1, "encoding failed");
+    mu_assert(size == encoded_size, "encoded size mismatch");
+    mu_assert(memcmp(out, encoded, encoded_size) == 0, "encoded content does not match reference");
+
+    size = lzw_encode(expected, expected_size, out, encoded_size - 1);
+    mu_assert(size == (size_t)-1, "encoding into a too small buffer should fail");
+
+    free(expected);
+    free(encoded);
+    free(out);
+}
+
+static void test_encode_roundtrip(const uint8_t *data, size_t size)
+{
+    size_t encoded_size = LZW_ENCODE_BOUND(size);
+    uint8_t *encoded = malloc(encoded_size);
+    uint8_t *decoded = malloc(size + 1);
+    mu_assert(encoded != NULL && decoded != NULL, "memory allocation failed");
+
+    encoded_size = lzw_encode(data, size, encoded, encoded_size);
+    mu_assert(encoded_size != (size_t)-1, "encoding failed");
+
+    size_t decoded_size = lzw_decode(encoded, encoded_size, decoded, size + 1);
+    mu_assert(decoded_size == size, "round trip size mismatch");
+    mu_assert(size == 0 || memcmp(decoded, data, size) == 0, "round trip content mismatch");
+
+    free(encoded);
+    free(decoded);
+}
+
+MU_TEST(test_encode_in_out)
+{
+    test_encode_base("test_data/out", "test_data/in");
+}
+
+MU_TEST(test_encode_aaa)
+{
+    test_encode_base("test_data/aaa.dec", "test_data/aaa.enc");
+}
+
+MU_TEST(test_encode_100_1)
+{
+    test_encode_base("test_data/100_1.dec", "test_data/100_1.enc");
+}
+
+MU_TEST(test_encode_1000)
+{
+    test_encode_base("test_data/1000.dec", "test_data/1000.enc");
+}
+
+MU_TEST(test_encode_empty)
+{
+    test_encode_roundtrip(NULL, 0);
+}
+
+MU_TEST(test_encode_generated)
+{
+    // Random, single-byte runs and a small alphabet: each fills the table
+    // several times, so CLEAR_CODE and every code width are exercised.
+    size_t size = 1 << 20;
+    uint8_t *data = malloc(size);
+    mu_assert(data != NULL, "memory allocation failed");
+
+    srand(1);
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = (uint8_t)rand();
+    }
+    test_encode_roundtrip(data, size);
+
+    memset(data, 'a', size);
+    test_encode_roundtrip(data, size);
+
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = (uint8_t)(rand() % 3);
+    }
+    test_encode_roundtrip(data, size);
+
+    free(data);
+}
+
+MU_TEST_SUITE(encode_suite)
+{
+    MU_RUN_TEST(test_encode_in_out);
+    MU_RUN_TEST(test_encode_aaa);
+    MU_RUN_TEST(test_encode_100_1);
+    MU_RUN_TEST(test_encode_1000);
+    MU_RUN_TEST(test_encode_empty);
+    MU_RUN_TEST(test_encode_generated);
+}
+
+// threads 0 means all CPUs; with_context runs the jobs with lzw_decode_jobs on
+// the calling thread instead.
+static void test_jobs(unsigned threads, bool with_context)
+{
+    const char *paths[][2] = {
+        {"test_data/in", "test_data/out"},           {"test_data/aaa.enc", "test_data/aaa.dec"},
+        {"test_data/10_1.enc", "test_data/10_1.dec"}, {"test_data/100_1.enc", "test_data/100_1.dec"},
+        {"test_data/1000.enc", "test_data/1000.dec"},
+    };
+    size_t path_count = sizeof(paths) / sizeof(paths[0]);
+    size_t encoded_sizes[5], expected_sizes[5];
+    uint8_t *encoded[5], *expected[5];
+
+    for (size_t i = 0; i < path_count; i++)
+    {
+        encoded[i] = read_file(paths[i][0], &encoded_sizes[i]);
+        expected[i] = read_file(paths[i][1], &expected_sizes[i]);
+        mu_assert(encoded[i] != NULL && expected[i] != NULL, "failed to read test data");
+    }
+
+    // Every seventh job gets one byte too little output space and must fail
+    // without affecting the others.
+    size_t count = 1000;
+    struct lzw_job *jobs = malloc(count * sizeof(*jobs));
+    mu_assert(jobs != NULL, "memory allocation failed");
+
+    size_t expected_failures = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t k = i % path_count;
+        jobs[i].in = encoded[k];
+        jobs[i].in_size = encoded_sizes[k];
+        jobs[i].out_size = expected_sizes[k] - (i % 7 == 0);
+        jobs[i].out = malloc(expected_sizes[k]);
+        jobs[i].result = 0;
+        jobs[i].error = SUCCESS;
+        mu_assert(jobs[i].out != NULL, "memory allocation failed");
+        expected_failures += i % 7 == 0;
+    }
+
+    static struct lzw_context ctx;
+    size_t failed =
+        with_context ? lzw_decode_jobs(&ctx, jobs, count) : lzw_decode_batch(jobs, count, lzw_decode_copy, threads);
+    mu_assert(failed == expected_failures, "unexpected number of failed jobs");
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t k = i % path_count;
+        if (i % 7 == 0)
+        {
+            mu_assert(jobs[i].result == (size_t)-1, "truncated job should fail");
+            mu_assert(jobs[i].error == OUTPUT_OVERFLOW, "truncated job should report the overflow");
+        }
+        else
+        {
+            mu_assert(jobs[i].result == expected_sizes[k], "job decoded size mismatch");
+            mu_assert(jobs[i].error == SUCCESS, "decoded job should report success");
+            mu_assert(memcmp(jobs[i].out, expected[k], expected_sizes[k]) == 0, "job content mismatch");
+        }
+        free(jobs[i].out);
+    }
+
+    for (size_t i = 0; i < path_count; i++)
+    {
+        free(encoded[i]);
+        free(expected[i]);
+    }
+    free(jobs);
+}
+
+MU_TEST(test_batch_one_thread)
+{
+    test_jobs(1, false);
+}
+
+MU_TEST(test_batch_three_threads)
+{
+    test_jobs(3, false);
+}
+
+MU_TEST(test_batch_all_cpus)
+{
+    test_jobs(0, false);
+}
+
+MU_TEST(test_batch_empty)
+{
+    mu_assert(lzw_decode_batch(NULL, 0, lzw_decode_copy, 0) == 0, "empty batch should succeed");
+}
+
+MU_TEST(test_decode_jobs)
+{
+    test_jobs(0, true);
+}
+
+MU_TEST(test_decode_jobs_invalid)
+{
+    static struct lzw_context ctx;
+    uint8_t out[4];
+    struct lzw_job jobs[2] = {{NULL, 3, out, sizeof(out), 0, SUCCESS}, {out, 0, NULL, 0, 0, SUCCESS}};
+    mu_assert(lzw_decode_jobs(&ctx, jobs, 2) == 1, "job without input should fail");
+    mu_assert(jobs[0].result == (size_t)-1 && jobs[1].result == 0, "job results mismatch");
+    mu_assert(jobs[0].error == INVALID_CODE && jobs[1].error == SUCCESS, "job errors mismatch");
+    mu_assert(lzw_decode_jobs(&ctx, NULL, 0) == 0, "empty job list should succeed");
+    mu_assert(lzw_decode_jobs(NULL, jobs, 2) == (size_t)-1, "missing context should fail");
+}
+
+MU_TEST_SUITE(batch_suite)
+{
+    MU_RUN_TEST(test_batch_one_thread);
+    MU_RUN_TEST(test_batch_three_threads);
+    MU_RUN_TEST(test_batch_all_cpus);
+    MU_RUN_TEST(test_batch_empty);
+    MU_RUN_TEST(test_decode_jobs);
+    MU_RUN_TEST(test_decode_jobs_invalid);
+}
+
+static void tiff_put(uint8_t *p, uint64_t value, unsigned size, bool big_endian)
+{
+    for (unsigned i = 0; i < size; i++)
+    {
+        p[big_endian ? size - 1 - i : i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint8_t tiff_test_byte(size_t segment, size_t i)
+{
+    return (uint8_t)((segment * 31 + i * 7) ^ (i / 5));
+}
+
+// A 37x29 RGB image, LZW compressed into strips of 8 rows or 16x16 tiles whose
+// content is tiff_test_byte, with sorted tags as the specification requires. Returns the file and its size.
+static uint8_t *make_tiff(bool big_endian, bool big_tiff, bool tiled, size_t *size)
+{
+    uint32_t width = 37, height = 29, tile = 16, rows_per_strip = 8;
+    size_t segment_count = tiled ? 3 * 2 : 4;
+    size_t value_size = big_tiff ? 8 : 4;
+    size_t entry_size = big_tiff ? 20 : 12;
+    size_t entry_count = tiled ? 9 : 8;
+
+    uint8_t *data = calloc(1 << 16, 1);
+    size_t at = big_tiff ? 16 : 8;
+    size_t offsets[8], byte_counts[8];
+    uint8_t raw[1024];
+
+    for (size_t s = 0; s < segment_count; s++)
+    {
+        size_t rows = tiled ? tile : (s == 3 ? height - 3 * rows_per_strip : rows_per_strip);
+        size_t raw_size = rows * (tiled ? tile : width) * 3;
+        for (size_t i = 0; i < raw_size; i++)
+        {
+            raw[i] = tiff_test_byte(s, i);
+        }
+        offsets[s] = at;
+        byte_counts[s] = lzw_encode(raw, raw_size, data + at, LZW_ENCODE_BOUND(raw_size));
+        at += byte_counts[s];
+    }
+
+    size_t offsets_at = at;
+    for (size_t s = 0; s < segment_count; s++, at += value_size)
+    {
+        tiff_put(data + at, offsets[s], value_size, big_endian);
+    }
+    size_t byte_counts_at = at;
+    for (size_t s = 0; s < segment_count; s++, at += value_size)
+    {
+        tiff_put(data + at, byte_counts[s], value_size, big_endian);
+    }
+
+    data[0] = data[1] = big_endian ? 'M' : 'I';
+    tiff_put(data + 2, big_tiff ? 43 : 42, 2, big_endian);
+    if (big_tiff)
+    {
+        tiff_put(data + 4, 8, 2, big_endian);
+        tiff_put(data + 8, at, 8, big_endian);
+    }
+    else
+    {
+        tiff_put(data + 4, at, 4, big_endian);
+    }
+
+    uint16_t offset_type = big_tiff ? 16 : 4;
+    uint64_t strip_entries[][4] = {
+        // tag, type, count, value
+        {256, 4, 1, width},
+        {257, 4, 1, height},
+        {258, 3, 1, 8},
+        {259, 3, 1, TIFF_COMPRESSION_LZW},
+        {273, offset_type, segment_count, offsets_at},
+        {277, 3, 1, 3},
+        {278, 4, 1, rows_per_strip},
+        {279, offset_type, segment_count, byte_counts_at},
+    };
+    uint64_t tile_entries[][4] = {
+        {256, 4, 1, width},
+        {257, 4, 1, height},
+        {258, 3, 1, 8},
+        {259, 3, 1, TIFF_COMPRESSION_LZW},
+        {277, 3, 1, 3},
+        {322, 4, 1, tile},
+        {323, 4, 1, tile},
+        {324, offset_type, segment_count, offsets_at},
+        {325, offset_type, segment_count, byte_counts_at},
+    };
+    uint64_t(*entries)[4] = tiled ? tile_entries : strip_entries;
+
+    tiff_put(data + at, entry_count, big_tiff ? 8 : 2, big_endian);
+    at += big_tiff ? 8 : 2;
+    for (size_t i = 0; i < entry_count; i++, at += entry_size)
+    {
+        tiff_put(data + at, entries[i][0], 2, big_endian);
+        tiff_put(data + at + 2, entries[i][1], 2, big_endian);
+        tiff_put(data + at + 4, entries[i][2], value_size, big_endian);
+        unsigned type_size = entries[i][1] == 3 ? 2 : entries[i][1] == 4 ? 4 : 8;
+        tiff_put(data + at + 4 + value_size, entries[i][3], entries[i][2] == 1 ? type_size : value_size, big_endian);
+    }
+    at += value_size; // next IFD: none
+
+    *size = at;
+    return data;
+}
+
+static void test_tiff_base(bool big_endian, bool big_tiff, bool tiled)
+{
+    size_t size;
+    uint8_t *data = make_tiff(big_endian, big_tiff, tiled, &size);
+    mu_assert(data != NULL, "memory allocation failed");
+
+    struct tiff_file f;
+    mu_assert(tiff_open_memory(&f, data, size) == SUCCESS, "failed to open TIFF");
+
+    struct tiff_image image;
+    uint64_t ifd = f.first_ifd;
+    int16_t result = tiff_read_ifd(&f, &ifd, &image);
+    mu_assert(result == SUCCESS, error_message(result));
+    mu_assert(ifd == 0, "expected a single image");
+    mu_assert(image.width == 37 && image.height == 29, "image size mismatch");
+    mu_assert(image.samples_per_pixel == 3 && image.bits_per_sample == 8, "sample format mismatch");
+    mu_assert(image.compression == TIFF_COMPRESSION_LZW, "compression mismatch");
+    mu_assert(image.tiled == tiled, "layout mismatch");
+    mu_assert(image.segment_count == (tiled ? 6u : 4u), "segment count mismatch");
+
+    uint8_t decoded[1024];
+    for (size_t s = 0; s < image.segment_count; s++)
+    {
+        const struct tiff_segment *segment = &image.segments[s];
+        size_t expected_size = tiled ? 16 * 16 * 3 : (s == 3 ? 5 : 8) * 37 * 3;
+        mu_assert(segment->decoded_size == expected_size, "segment decoded size mismatch");
+        mu_assert(segment->data >= data && segment->data + segment->size <= data + size, "segment not in file");
+
+        size_t decoded_size = lzw_decode(segment->data, segment->size, decoded, segment->decoded_size);
+        mu_assert(decoded_size == expected_size, "segment decode failed");
+        for (size_t i = 0; i < decoded_size; i++)
+        {
+            mu_assert(decoded[i] == tiff_test_byte(s, i), "segment content mismatch");
+        }
+    }
+
+    tiff_image_free(&image);
+    tiff_close(&f);
+    free(data);
+}
+
+MU_TEST(test_tiff_strips)
+{
+    test_tiff_base(false, false, false);
+}
+
+MU_TEST(test_tiff_tiles_big_endian)
+{
+    test_tiff_base(true, false, true);
+}
+
+MU_TEST(test_tiff_big_tiff)
+{
+    test_tiff_base(false, true, false);
+    test_tiff_base(true, true, true);
+}
+
+MU_TEST(test_tiff_invalid)
+{
+    struct tiff_file f;
+    mu_assert(tiff_open(&f, "test_data/missing.tif") == INVALID_TIFF, "missing file should fail");
+    mu_assert(tiff_open(&f, "test_data/in") == INVALID_TIFF, "non-TIFF file should fail");
+
+    // A strip offset past the end of the file
+    size_t size;
+    uint8_t *data = make_tiff(false, false, false, &size);
+    mu_assert(tiff_open_memory(&f, data, size) == SUCCESS, "failed to open TIFF");
+    uint8_t *strip_offsets = data + f.first_ifd + 2 + 4 * 12 + 8;
+    tiff_put(data + (strip_offsets[0] | strip_offsets[1] << 8), size, 4, false);
+
+    struct tiff_image image;
+    uint64_t ifd = f.first_ifd;
+    mu_assert(tiff_read_ifd(&f, &ifd, &image) == INVALID_TIFF, "out of file strip should fail");
+
+    // Truncated in the middle of the IFD
+    mu_assert(tiff_open_memory(&f, data, f.first_ifd + 20) == SUCCESS, "failed to open TIFF");
+    ifd = f.first_ifd;
+    mu_assert(tiff_read_ifd(&f, &ifd, &image) == INVALID_TIFF, "truncated IFD should fail");
+
+    free(data);
+}
+
+MU_TEST_SUITE(tiff_suite)
 {
+    MU_RUN_TEST(test_tiff_strips);
+    MU_RUN_TEST(test_tiff_tiles_big_endian);
+    MU_RUN_TEST(test_tiff_big_tiff);
+    MU_RUN_TEST(test_tiff_invalid);
+}
+
+// Horizontal differencing as a TIFF writer applies it, last sample first.
+static void predictor_apply(uint8_t *data, size_t size, const struct lzw_predictor *p)
+{
+    size_t stride = (size_t)p->bytes_per_sample * p->samples_per_pixel;
+    for (size_t row = 0; row < size; row += p->row_size)
+    {
+        size_t end = size - row < p->row_size ? size - row : p->row_size;
+        uint8_t *r = data + row;
+        for (size_t i = end - p->bytes_per_sample; i >= stride && i < end; i -= p->bytes_per_sample)
+        {
+            if (p->bytes_per_sample == 1)
+            {
+                r[i] -= r[i - stride];
+            }
+            else
+            {
+                size_t hi = p->big_endian ? 0 : 1;
+                uint16_t value = (uint16_t)(r[i + hi] << 8 | r[i + 1 - hi]);
+                uint16_t previous = (uint16_t)(r[i - stride + hi] << 8 | r[i - stride + 1 - hi]);
+                value -= previous;
+                r[i + hi] = (uint8_t)(value >> 8);
+                r[i + 1 - hi] = (uint8_t)value;
+            }
+        }
+    }
+}
+
+static void test_predictor_base(size_t width, size_t rows, size_t extra, uint8_t bytes_per_sample,
+                                uint8_t samples_per_pixel, bool big_endian)
+{
+    struct lzw_predictor p = {width * bytes_per_sample * samples_per_pixel, bytes_per_sample, samples_per_pixel,
+                              big_endian};
+    size_t size = p.row_size * rows + extra;
+
+    uint8_t *image = malloc(size);
+    uint8_t *differenced = malloc(size);
+    uint8_t *encoded = malloc(LZW_ENCODE_BOUND(size));
+    uint8_t *decoded = malloc(size);
+    mu_assert(image != NULL && differenced != NULL && encoded != NULL && decoded != NULL, "memory allocation failed");
+
+    srand(7);
+    for (size_t i = 0; i < size; i++)
+    {
+        image[i] = (uint8_t)(i / 3 + (i % p.row_size) * 5 + rand() % 4);
+    }
+    memcpy(differenced, image, size);
+    predictor_apply(differenced, size, &p);
+
+    size_t encoded_size = lzw_encode(differenced, size, encoded, LZW_ENCODE_BOUND(size));
+    mu_assert(encoded_size != (size_t)-1, "encoding failed");
+
+    size_t decoded_size = lzw_decode_predictor(encoded, encoded_size, decoded, size, &p);
+    mu_assert(decoded_size == size, "decoded size mismatch");
+    mu_assert(memcmp(decoded, image, size) == 0, "predictor was not undone");
+
+    decoded_size = lzw_decode_predictor(encoded, encoded_size, decoded, size - 1, &p);
+    mu_assert(decoded_size == (size_t)-1, "decoding into a too small buffer should fail");
+
+    free(image);
+    free(differenced);
+    free(encoded);
+    free(decoded);
+}
+
+MU_TEST(test_predictor_8_bit)
+{
+    test_predictor_base(1000, 20, 0, 1, 1, false);
+    test_predictor_base(37, 50, 11, 1, 1, false);
+    test_predictor_base(333, 9, 0, 1, 2, false);
+    test_predictor_base(37, 31, 0, 1, 3, false);
+    test_predictor_base(129, 17, 5, 1, 4, false);
+    test_predictor_base(65, 10, 0, 1, 8, false);
+    // Many table generations, with rows straddling the CLEAR codes
+    test_predictor_base(1001, 300, 13, 1, 3, false);
+}
+
+MU_TEST(test_predictor_16_bit)
+{
+    test_predictor_base(1000, 20, 0, 2, 1, false);
+    test_predictor_base(101, 13, 6, 2, 3, false);
+    test_predictor_base(64, 16, 0, 2, 4, false);
+    test_predictor_base(250, 12, 0, 2, 1, true);
+    test_predictor_base(77, 12, 4, 2, 2, true);
+    test_predictor_base(999, 100, 2, 2, 1, false);
+}
+
+MU_TEST(test_predictor_invalid)
+{
+    uint8_t encoded[] = {0x80, 0x00, 0x00};
+    uint8_t decoded[16];
+    struct lzw_predictor bad_sample = {12, 3, 1, false};
+    struct lzw_predictor bad_row = {7, 2, 1, false};
+
+    mu_assert(lzw_decode_predictor(encoded, sizeof(encoded), decoded, sizeof(decoded), NULL) == (size_t)-1,
+              "missing predictor should fail");
+    mu_assert(lzw_decode_predictor(encoded, sizeof(encoded), decoded, sizeof(decoded), &bad_sample) == (size_t)-1,
+              "unsupported sample size should fail");
+    mu_assert(lzw_decode_predictor(encoded, sizeof(encoded), decoded, sizeof(decoded), &bad_row) == (size_t)-1,
+              "row of partial pixels should fail");
+}
+
+MU_TEST_SUITE(predictor_suite)
+{
+    MU_RUN_TEST(test_predictor_8_bit);
+    MU_RUN_TEST(test_predictor_16_bit);
+    MU_RUN_TEST(test_predictor_invalid);
+}
+
+static void test_decoded_size_base(const char *encoded_path, const char *expected_path)
+{
+    size_t encoded_size, expected_size;
+    uint8_t *encoded = read_file(encoded_path, &encoded_size);
+    uint8_t *expected = read_file(expected_path, &expected_size);
+    mu_assert(encoded != NULL && expected != NULL, "failed to read test data");
+
+    size_t size = lzw_decoded_size(encoded, encoded_size);
+    mu_assert(size == expected_size, "decoded size mismatch");
+
+    // Exactly that much output is enough
+    uint8_t *decoded = malloc(size);
+    mu_assert(decoded != NULL, "memory allocation failed");
+    mu_assert(lzw_decode_copy(encoded, encoded_size, decoded, size) == size, "decode into exact size failed");
+    mu_assert(memcmp(decoded, expected, size) == 0, "decoded content does not match expected");
+
+    free(encoded);
+    free(expected);
+    free(decoded);
+}
+
+MU_TEST(test_decoded_size_files)
+{
+    test_decoded_size_base("test_data/in", "test_data/out");
+    test_decoded_size_base("test_data/aaa.enc", "test_data/aaa.dec");
+    test_decoded_size_base("test_data/10_1.enc", "test_data/10_1.dec");
+    test_decoded_size_base("test_data/100_1.enc", "test_data/100_1.dec");
+    test_decoded_size_base("test_data/1000.enc", "test_data/1000.dec");
+}
+
+MU_TEST(test_decoded_size_generated)
+{
+    // Small alphabet runs fill the table several times and exercise KwKwK codes
+    size_t size = 1 << 18;
+    uint8_t *data = malloc(size);
+    size_t encoded_size = LZW_ENCODE_BOUND(size);
+    uint8_t *encoded = malloc(encoded_size);
+    mu_assert(data != NULL && encoded != NULL, "memory allocation failed");
+
+    srand(15);
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = (uint8_t)(rand() % 3);
+    }
+    encoded_size = lzw_encode(data, size, encoded, encoded_size);
+    mu_assert(encoded_size != (size_t)-1, "encoding failed");
+    mu_assert(lzw_decoded_size(encoded, encoded_size) == size, "decoded size mismatch");
+
+    free(data);
+    free(encoded);
+}
+
+MU_TEST(test_decoded_size_invalid)
+{
+    // CLEAR, then code 258 while the table is empty
+    const uint8_t undefined_code[] = {0x80, 0x40, 0x80};
+    mu_assert(lzw_decoded_size(undefined_code, sizeof(undefined_code)) == (size_t)-1, "undefined code should fail");
+    mu_assert(lzw_decoded_size(NULL, 0) == (size_t)-1, "NULL input should fail");
+    mu_assert(lzw_decoded_size(undefined_code, 0) == 0, "empty input should decode to nothing");
+}
+
+MU_TEST_SUITE(decoded_size_suite)
+{
+    MU_RUN_TEST(test_decoded_size_files);
+    MU_RUN_TEST(test_decoded_size_generated);
+    MU_RUN_TEST(test_decoded_size_invalid);
+}
+
+// Compares lzw_decode_range over windows that start before, at and after
+// every checkpoint and run past the end of the data with expected.
+static void test_index_ranges(const uint8_t *encoded, size_t encoded_size, const struct lzw_index *index,
+                              const uint8_t *expected, size_t expected_size)
+{
+    size_t sizes[] = {1, 100, 5000};
+    uint8_t *out = malloc(5000);
+    mu_assert(out != NULL, "memory allocation failed");
+
+    for (size_t i = 0; i < index->count; i++)
+    {
+        for (size_t j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++)
+        {
+            uint64_t checkpoint = index->checkpoints[i].out_offset;
+            uint64_t offsets[] = {checkpoint > 7 ? checkpoint - 7 : 0, checkpoint, checkpoint + 3,
+                                  expected_size - 10};
+            for (size_t k = 0; k < sizeof(offsets) / sizeof(offsets[0]); k++)
+            {
+                uint64_t offset = offsets[k];
+                size_t size = lzw_decode_range(encoded, encoded_size, index, offset, out, sizes[j]);
+                size_t expected_range = offset + sizes[j] <= expected_size ? sizes[j] : expected_size - offset;
+                mu_assert(size == expected_range, "range size mismatch");
+                mu_assert(memcmp(out, expected + offset, size) == 0, "range content does not match expected");
+            }
+        }
+    }
+
+    mu_assert(lzw_decode_range(encoded, encoded_size, index, expected_size, out, 10) == 0,
+              "range past the end should be empty");
+
+    free(out);
+}
+
+MU_TEST(test_index_in_out)
+{
+    size_t encoded_size, expected_size;
+    uint8_t *encoded = read_file("test_data/in", &encoded_size);
+    uint8_t *expected = read_file("test_data/out", &expected_size);
+    mu_assert(encoded != NULL && expected != NULL, "failed to read test data");
+
+    struct lzw_index index;
+    mu_assert(lzw_index_build(&index, encoded, encoded_size) == SUCCESS, "index build failed");
+    mu_assert(index.decoded_size == expected_size, "indexed size mismatch");
+    mu_assert(index.count > 1, "the stream has CLEAR codes after the first");
+
+    test_index_ranges(encoded, encoded_size, &index, expected, expected_size);
+
+    lzw_index_free(&index);
+    free(encoded);
+    free(expected);
+}
+
+MU_TEST(test_index_generated)
+{
+    size_t size = 1 << 18;
+    uint8_t *data = malloc(size);
+    size_t encoded_size = LZW_ENCODE_BOUND(size);
+    uint8_t *encoded = malloc(encoded_size);
+    mu_assert(data != NULL && encoded != NULL, "memory allocation failed");
+
+    srand(16);
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = (uint8_t)(rand() % 5);
+    }
+    encoded_size = lzw_encode(data, size, encoded, encoded_size);
+    mu_assert(encoded_size != (size_t)-1, "encoding failed");
+
+    struct lzw_index index;
+    mu_assert(lzw_index_build(&index, encoded, encoded_size) == SUCCESS, "index build failed");
+    mu_assert(index.decoded_size == size, "indexed size mismatch");
+
+    test_index_ranges(encoded, encoded_size, &index, data, size);
+
+    // A stream of another size is not the indexed one
+    uint8_t out[16];
+    mu_assert(lzw_decode_range(encoded, encoded_size - 1, &index, 0, out, sizeof(out)) == (size_t)-1,
+              "mismatched stream should fail");
+
+    lzw_index_free(&index);
+    free(data);
+    free(encoded);
+}
+
+MU_TEST(test_index_save_load)
+{
+    size_t encoded_size, expected_size;
+    uint8_t *encoded = read_file("test_data/in", &encoded_size);
+    uint8_t *expected = read_file("test_data/out", &expected_size);
+    mu_assert(encoded != NULL && expected != NULL, "failed to read test data");
+
+    struct lzw_index index, loaded;
+    mu_assert(lzw_index_build(&index, encoded, encoded_size) == SUCCESS, "index build failed");
+    mu_assert(lzw_index_save(&index, "bin/test.lzwi") == SUCCESS, "index save failed");
+    mu_assert(lzw_index_load(&loaded, "bin/test.lzwi") == SUCCESS, "index load failed");
+
+    mu_assert(loaded.in_size == index.in_size && loaded.decoded_size == index.decoded_size &&
+                  loaded.count == index.count,
+              "loaded index header mismatch");
+    mu_assert(memcmp(loaded.checkpoints, index.checkpoints, index.count * sizeof(*index.checkpoints)) == 0,
+              "loaded checkpoints mismatch");
+    test_index_ranges(encoded, encoded_size, &loaded, expected, expected_size);
+    lzw_index_free(&loaded);
+
+    // Truncated file and unsorted checkpoints
+    FILE *f = fopen("bin/test.lzwi", "r+b");
+    mu_assert(f != NULL, "failed to reopen index");
+    fseek(f, 32 + 16 + 8, SEEK_SET);
+    fputc(0, f);
+    fputc(0, f);
+    fputc(0, f);
+    fclose(f);
+    mu_assert(lzw_index_load(&loaded, "bin/test.lzwi") == INVALID_INDEX, "unsorted index should fail to load");
+    mu_assert(loaded.checkpoints == NULL, "failed load should not keep checkpoints");
+
+    index.count--;
+    mu_assert(lzw_index_save(&index, "bin/test.lzwi") == SUCCESS, "index save failed");
+    index.count++;
+    f = fopen("bin/test.lzwi", "r+b");
+    mu_assert(f != NULL, "failed to reopen index");
+    fseek(f, 24, SEEK_SET);
+    fputc((int)index.count, f);
+    fclose(f);
+    mu_assert(lzw_index_load(&loaded, "bin/test.lzwi") == INVALID_INDEX, "truncated index should fail to load");
+    mu_assert(lzw_index_load(&loaded, "test_data/in") == INVALID_INDEX, "non-index file should fail to load");
+    remove("bin/test.lzwi");
+
+    lzw_index_free(&index);
+    lzw_index_free(&loaded);
+    free(encoded);
+    free(expected);
+}
+
+MU_TEST(test_index_invalid)
+{
+    // CLEAR, then code 258 while the table is empty
+    const uint8_t undefined_code[] = {0x80, 0x40, 0x80};
+    struct lzw_index index;
+    mu_assert(lzw_index_build(&index, undefined_code, sizeof(undefined_code)) == INVALID_CODE,
+              "undefined code should fail");
+    mu_assert(index.checkpoints == NULL, "failed build should not keep checkpoints");
+}
+
+MU_TEST_SUITE(index_suite)
+{
+    MU_RUN_TEST(test_index_in_out);
+    MU_RUN_TEST(test_index_generated);
+    MU_RUN_TEST(test_index_save_load);
+    MU_RUN_TEST(test_index_invalid);
+}
+
+#ifdef LZW_STATS
+static size_t stats_decode_checked(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+{
+    size_t size;
+    return lzw_decode_checked(in, in_size, out, out_size, &size) == SUCCESS ? size : (size_t)-1;
+}
+
+// Both counted engines: the kernel behind lzw_decode and lzw_decode_checked
+static const lzw_decode_fn stats_engines[] = {lzw_decode, stats_decode_checked};
+
+MU_TEST(test_stats_counters)
+{
+    // PDF reference example: CLEAR 45 258 258 65 259 66 EOD, "-----A---B"
+    const uint8_t encoded[] = {0x80, 0x0b, 0x60, 0x50, 0x22, 0x0c, 0x0c, 0x85, 0x01};
+    uint8_t out[16];
+
+    for (size_t e = 0; e < sizeof(stats_engines) / sizeof(stats_engines[0]); e++)
+    {
+        lzw_stats_reset();
+        mu_assert(stats_engines[e](encoded, sizeof(encoded), out, sizeof(out)) == 10, "decoded size mismatch");
+        mu_assert(lzw_stats.codes == 8, "codes mismatch");
+        mu_assert(lzw_stats.clears == 1, "clears mismatch");
+        mu_assert(lzw_stats.kwkwk == 1, "KwKwK count mismatch");
+        mu_assert(lzw_stats.strings == 6 && lzw_stats.string_bytes == 10, "string count mismatch");
+        mu_assert(lzw_stats.max_string_length == 3, "max string length mismatch");
+        mu_assert(lzw_stats.width_changes == 0, "width changes mismatch");
+        // The first code, the CLEAR_CODE, is the only one sampled
+        mu_assert(lzw_stats.sampled_codes == 1 && lzw_stats.table_cycles > 0 && lzw_stats.write_cycles == 0,
+                  "the CLEAR_CODE should be sampled");
+    }
+}
+
+MU_TEST(test_stats_widths)
+{
+    size_t encoded_size, expected_size;
+    uint8_t *encoded = read_file("test_data/in", &encoded_size);
+    uint8_t *expected = read_file("test_data/out", &expected_size);
+    uint8_t *decoded = malloc(expected_size);
+    mu_assert(encoded != NULL && expected != NULL && decoded != NULL, "failed to read test data");
+
+    for (size_t e = 0; e < sizeof(stats_engines) / sizeof(stats_engines[0]); e++)
+    {
+        lzw_stats_reset();
+        mu_assert(stats_engines[e](encoded, encoded_size, decoded, expected_size) == expected_size,
+                  "decoded size mismatch");
+        mu_assert(lzw_stats.string_bytes == expected_size, "string bytes should add up to the output");
+        // Every table but the last fills up, going through 10, 11 and 12 bits
+        mu_assert(lzw_stats.clears > 1, "the stream has several tables");
+        mu_assert(lzw_stats.width_changes <= 3 * lzw_stats.clears &&
+                      lzw_stats.width_changes >= 3 * (lzw_stats.clears - 1),
+                  "width changes mismatch");
+        // Every 64th code is timed, whatever it is, starting with the first
+        mu_assert(lzw_stats.sampled_codes == (lzw_stats.codes + LZW_STATS_SAMPLE - 1) / LZW_STATS_SAMPLE,
+                  "sampled codes mismatch");
+        mu_assert(lzw_stats.read_cycles > 0 && lzw_stats.table_cycles > 0 && lzw_stats.write_cycles > 0,
+                  "every phase should be timed");
+    }
+
+    free(encoded);
+    free(expected);
+    free(decoded);
+}
+
+MU_TEST_SUITE(stats_suite)
+{
+    MU_RUN_TEST(test_stats_counters);
+    MU_RUN_TEST(test_stats_widths);
+}
+#endif
+
+MU_TEST(test_checked_errors)
+{
+    // PDF reference example: CLEAR 45 258 258 65 259 66 EOD, "-----A---B"
+    const uint8_t encoded[] = {0x80, 0x0b, 0x60, 0x50, 0x22, 0x0c, 0x0c, 0x85, 0x01};
+    uint8_t out[10];
+    size_t size;
+
+    mu_assert(lzw_decode_checked(encoded, sizeof(encoded), out, sizeof(out), &size) == SUCCESS && size == 10,
+              "decoding failed");
+    for (size_t out_size = 0; out_size < sizeof(out); out_size++)
+    {
+        mu_assert(lzw_decode_checked(encoded, sizeof(encoded), out, out_size, &size) == OUTPUT_OVERFLOW,
+                  "too small output should overflow");
+        mu_assert(size <= out_size, "decoded past out_size");
+    }
+
+    // CLEAR 65 300, while the table ends at 258
+    const uint8_t undefined_code[] = {0x80, 0x10, 0x65, 0x80};
+    mu_assert(lzw_decode_checked(undefined_code, sizeof(undefined_code), out, sizeof(out), &size) == INVALID_CODE,
+              "undefined code should fail");
+    mu_assert(size == 1, "bytes before the error should be counted");
+
+    // CLEAR 258: no string to extend yet
+    const uint8_t code_after_clear[] = {0x80, 0x40, 0x80};
+    mu_assert(lzw_decode_checked(code_after_clear, sizeof(code_after_clear), out, sizeof(out), &size) ==
+                  INVALID_CODE,
+              "non-literal code after CLEAR should fail");
+    mu_assert(strcmp(error_message(OUTPUT_OVERFLOW), "Output buffer too small") == 0, "error message mismatch");
+}
+
+static void put_code(uint8_t *out, size_t *bit, uint16_t code, uint8_t bits_count)
+{
+    for (int i = bits_count - 1; i >= 0; i--, (*bit)++)
+    {
+        out[*bit / 8] |= ((code >> i) & 1) << (7 - *bit % 8);
+    }
+}
+
+MU_TEST(test_checked_full_table)
+{
+    // Literals with no CLEAR_CODE once the table is full, which stays frozen
+    size_t codes = 5000;
+    uint8_t *encoded = calloc(codes * 2 + 4, 1);
+    uint8_t *decoded = malloc(codes);
+    uint8_t *reference = malloc(codes);
+    mu_assert(encoded != NULL && decoded != NULL && reference != NULL, "memory allocation failed");
+
+    size_t bit = 0;
+    uint8_t bits_count = 9;
+    uint16_t next_code = FIRST_CODE;
+    put_code(encoded, &bit, CLEAR_CODE, bits_count);
+    for (size_t i = 0; i < codes; i++)
+    {
+        put_code(encoded, &bit, i % 7, bits_count);
+        if (i > 0 && next_code < MAX_CODE && ++next_code + 1 == 1 << bits_count && bits_count < MAX_BITS_COUNT)
+        {
+            bits_count++;
+        }
+    }
+    put_code(encoded, &bit, END_OF_INFORMATION, bits_count);
+
+    size_t size;
+    mu_assert(lzw_decode_checked(encoded, (bit + 7) / 8, decoded, codes, &size) == SUCCESS, "decoding failed");
+    mu_assert(size == codes, "decoded size mismatch");
+    mu_assert(lzw_decode_copy(encoded, (bit + 7) / 8, reference, codes) == codes, "reference decoding failed");
+    mu_assert(memcmp(decoded, reference, codes) == 0, "decoded content does not match lzw_decode_copy");
+
+    free(encoded);
+    free(decoded);
+    free(reference);
+}
+
+MU_TEST_SUITE(checked_suite)
+{
+    MU_RUN_TEST(test_checked_errors);
+    MU_RUN_TEST(test_checked_full_table);
+}
+
+static void run_decode_suite(lzw_decode_fn fn, size_t fn_in_slack, size_t fn_out_slack)
+{
+    decode = fn;
+    in_slack = fn_in_slack;
+    out_slack = fn_out_slack;
     MU_RUN_SUITE(decode_suite);
+}
+
+MU_TEST(test_kernel_select)
+{
+    mu_assert(lzw_kernel_supported(LZW_KERNEL_BASELINE), "baseline kernel should always be supported");
+    mu_assert(lzw_kernel_supported(lzw_kernel_selected()), "selected kernel should be supported");
+    mu_assert(!lzw_kernel_select(LZW_KERNEL_COUNT), "selecting an unknown kernel should fail");
+    mu_assert(strcmp(lzw_kernel_name(LZW_KERNEL_AVX2), "avx2") == 0, "kernel name mismatch");
+}
+
+// With room to spare, no kernel writes past the decoded size
+MU_TEST(test_kernel_output_bounds)
+{
+    size_t encoded_size, expected_size;
+    uint8_t *encoded = read_file("test_data/in", &encoded_size);
+    uint8_t *expected = read_file("test_data/out", &expected_size);
+    uint8_t *decoded = malloc(expected_size + 64);
+    mu_assert(encoded != NULL && expected != NULL && decoded != NULL, "failed to read test data");
+
+    enum lzw_kernel kernel = lzw_kernel_selected();
+    for (int k = 0; k < LZW_KERNEL_COUNT; k++)
+    {
+        if (!lzw_kernel_select(k))
+        {
+            continue;
+        }
+
+        memset(decoded, 0xA5, expected_size + 64);
+        mu_assert(lzw_decode_auto(encoded, encoded_size, decoded, expected_size + 64) == expected_size,
+                  "decoded size mismatch");
+        mu_assert(memcmp(decoded, expected, expected_size) == 0, "decoded data mismatch");
+        for (size_t i = expected_size; i < expected_size + 64; i++)
+        {
+            mu_assert(decoded[i] == 0xA5, "kernel wrote past the decoded size");
+        }
+    }
+    lzw_kernel_select(kernel);
+
+    free(encoded);
+    free(expected);
+    free(decoded);
+}
+
+MU_TEST_SUITE(dispatch_suite)
+{
+    MU_RUN_TEST(test_kernel_select);
+    MU_RUN_TEST(test_kernel_output_bounds);
+}
+
+// One context for every call, so each buffer sees the entries of the last
+static size_t decode_with_context(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+{
+    static struct lzw_context ctx;
+    return lzw_decode_context(&ctx, in, in_size, out, out_size);
+}
+
+static size_t decode_checked(const uint8_t *in, size_t in_size, uint8_t *restrict out, size_t out_size)
+{
+    size_t size;
+    return lzw_decode_checked(in, in_size, out, out_size, &size) == SUCCESS ? size : (size_t)-1;
+}
+
+int main(int argc, char *argv[])
+{
+    run_decode_suite(lzw_decode, 0, 0);
+    run_decode_suite(decode_checked, 0, 0);
+    run_decode_suite(lzw_decode_copy, 0, 0);
+    run_decode_suite(decode_with_context, 0, 0);
+    enum lzw_kernel kernel = lzw_kernel_selected();
+    for (int k = 0; k < LZW_KERNEL_COUNT; k++)
+    {
+        if (lzw_kernel_select(k))
+        {
+            run_decode_suite(lzw_decode_auto, 0, 0);
+        }
+    }
+    lzw_kernel_select(kernel);
+    MU_RUN_SUITE(dispatch_suite);
+#ifdef LZW_FAST
+    run_decode_suite(lzw_decode_fast, LZW_FAST_IN_SLACK, LZW_FAST_OUT_SLACK);
+#endif
+    MU_RUN_SUITE(stream_suite);
+    MU_RUN_SUITE(encode_suite);
+    MU_RUN_SUITE(batch_suite);
+    MU_RUN_SUITE(tiff_suite);
+    MU_RUN_SUITE(predictor_suite);
+    MU_RUN_SUITE(decoded_size_suite);
+    MU_RUN_SUITE(index_suite);
+    MU_RUN_SUITE(checked_suite);
+#ifdef LZW_STATS
+    MU_RUN_SUITE(stats_suite);
+#endif
     MU_REPORT();
     return MU_EXIT_CODE;
 }
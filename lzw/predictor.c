@@ -0,0 +1,155 @@
+#include "predictor.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define PREDICTOR_SSE2
+#endif
+
+bool predictor_valid(const struct lzw_predictor *p)
+{
+    if (p == NULL || (p->bytes_per_sample != 1 && p->bytes_per_sample != 2) || p->samples_per_pixel == 0)
+    {
+        return false;
+    }
+
+    size_t pixel_size = (size_t)p->bytes_per_sample * p->samples_per_pixel;
+    return p->row_size != 0 && p->row_size % pixel_size == 0;
+}
+
+static void predictor_undo_8(uint8_t *row, size_t begin, size_t size, size_t stride)
+{
+    for (size_t i = begin > stride ? begin : stride; i < size; i++)
+    {
+        row[i] += row[i - stride];
+    }
+}
+
+static void predictor_undo_16(uint8_t *row, size_t begin, size_t size, size_t stride, bool big_endian)
+{
+    // size is rounded down to whole samples; a trailing odd byte stays as is.
+    size &= ~(size_t)1;
+    for (size_t i = begin > stride ? begin : stride; i < size; i += 2)
+    {
+        uint16_t value, previous;
+        if (big_endian)
+        {
+            value = (uint16_t)(row[i] << 8 | row[i + 1]);
+            previous = (uint16_t)(row[i - stride] << 8 | row[i - stride + 1]);
+        }
+        else
+        {
+            value = (uint16_t)(row[i + 1] << 8 | row[i]);
+            previous = (uint16_t)(row[i - stride + 1] << 8 | row[i - stride]);
+        }
+
+        value += previous;
+        row[i + (big_endian ? 1 : 0)] = (uint8_t)value;
+        row[i + (big_endian ? 0 : 1)] = (uint8_t)(value >> 8);
+    }
+}
+
+#ifdef PREDICTOR_SSE2
+// Prefix sum with the given stride (1, 2, 4 or 8 bytes) over 16-byte blocks:
+// log2(16 / stride) shifted adds inside the block, then the last pixel of the
+// previous block is broadcast and added. Returns the number of bytes done.
+// Compiled for SSE2 whatever the build targets, so i686 builds have it too.
+__attribute__((target("sse2"))) static size_t predictor_undo_sse2(uint8_t *row, size_t size, size_t stride, bool wide)
+{
+    __m128i carry = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(row + i));
+
+        if (wide)
+        {
+            if (stride <= 2)
+            {
+                x = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+            }
+            if (stride <= 4)
+            {
+                x = _mm_add_epi16(x, _mm_slli_si128(x, 4));
+            }
+            x = _mm_add_epi16(x, _mm_slli_si128(x, 8));
+            x = _mm_add_epi16(x, carry);
+        }
+        else
+        {
+            if (stride == 1)
+            {
+                x = _mm_add_epi8(x, _mm_slli_si128(x, 1));
+            }
+            if (stride <= 2)
+            {
+                x = _mm_add_epi8(x, _mm_slli_si128(x, 2));
+            }
+            if (stride <= 4)
+            {
+                x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+            }
+            x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+            x = _mm_add_epi8(x, carry);
+        }
+
+        _mm_storeu_si128((__m128i *)(row + i), x);
+
+        switch (stride)
+        {
+        case 1:
+            carry = _mm_set1_epi8((char)row[i + 15]);
+            break;
+        case 2:
+            carry = _mm_shuffle_epi32(_mm_shufflehi_epi16(x, 0xFF), 0xFF);
+            break;
+        case 4:
+            carry = _mm_shuffle_epi32(x, 0xFF);
+            break;
+        default:
+            carry = _mm_unpackhi_epi64(x, x);
+            break;
+        }
+    }
+
+    return i;
+}
+#endif
+
+void predictor_undo(uint8_t *row, size_t size, const struct lzw_predictor *p)
+{
+    size_t stride = (size_t)p->bytes_per_sample * p->samples_per_pixel;
+    size_t done = 0;
+
+#ifdef PREDICTOR_SSE2
+    // Pixels that divide 16 bytes, in host byte order
+    bool wide = p->bytes_per_sample == 2;
+    if ((stride == 1 || stride == 2 || stride == 4 || stride == 8) && !(wide && p->big_endian) &&
+        __builtin_cpu_supports("sse2"))
+    {
+        done = predictor_undo_sse2(row, size, stride, wide);
+    }
+#endif
+
+    if (p->bytes_per_sample == 1)
+    {
+        predictor_undo_8(row, done, size, stride);
+    }
+    else
+    {
+        predictor_undo_16(row, done, size, stride, p->big_endian);
+    }
+}
+
+size_t predictor_undo_rows(uint8_t *image, size_t begin, size_t end, const struct lzw_predictor *p)
+{
+    for (; end - begin >= p->row_size; begin += p->row_size)
+    {
+        predictor_undo(image + begin, p->row_size, p);
+    }
+    return begin;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// TIFF Predictor=2 (horizontal differencing) over rows of row_size bytes made
+// of samples_per_pixel samples of bytes_per_sample (1 or 2) bytes each;
+// big_endian gives the byte order of 16-bit samples.
+struct lzw_predictor
+{
+    size_t row_size;
+    uint8_t bytes_per_sample;
+    uint8_t samples_per_pixel;
+    bool big_endian;
+};
+
+bool predictor_valid(const struct lzw_predictor *p);
+
+// Undoes the differencing of one row, or of the first size bytes of a row.
+void predictor_undo(uint8_t *row, size_t size, const struct lzw_predictor *p);
+
+// Undoes the whole rows of an image from offset begin, a row start, up to
+// offset end. Returns the offset of the first row left as it is.
+size_t predictor_undo_rows(uint8_t *image, size_t begin, size_t end, const struct lzw_predictor *p);
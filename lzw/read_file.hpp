@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Test and benchmark support for the lzw.hpp variants: the whole file, or an
+// empty vector if it cannot be read.
+inline std::vector<uint8_t> read_file(const char *path)
+{
+    std::vector<uint8_t> data;
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr)
+    {
+        return data;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    data.resize(file_size > 0 ? static_cast<size_t>(file_size) : 0);
+    if (fread(data.data(), 1, data.size(), f) != data.size())
+    {
+        data.clear();
+    }
+    fclose(f);
+
+    return data;
+}
@@ -5,36 +5,61 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 void reader_init(struct reader *r, uint8_t const *data, size_t size)
 {
     r->data = data;
     r->size = size;
     r->byte_index = 0;
-    r->bit_index = 0;
+    r->buffer = 0;
+    r->bits_available = 0;
 }
 
-uint16_t reader_next(struct reader *r, uint8_t bits_count)
+static void reader_refill(struct reader *r)
 {
-    uint32_t data = ((uint32_t)r->data[r->byte_index] << 24);
-
-    data |= ((uint32_t)r->data[r->byte_index + 1] << 16);
+    if (r->byte_index + 8 <= r->size)
+    {
+        // Load 8 bytes and keep the whole ones that fit; the bits below
+        // bits_available are the same bytes the next refill loads again.
+        uint64_t data;
+        memcpy(&data, r->data + r->byte_index, sizeof(data));
+        r->buffer |= __builtin_bswap64(data) >> r->bits_available;
+        r->byte_index += (63 - r->bits_available) >> 3;
+        r->bits_available |= 56;
+        return;
+    }
 
-    if (r->bit_index + bits_count > 16)
-        data |= ((uint32_t)r->data[r->byte_index + 2] << 8);
+    // Last bytes of the input: never read past size.
+    while (r->bits_available <= 56 && r->byte_index < r->size)
+    {
+        r->buffer |= (uint64_t)r->data[r->byte_index] << (56 - r->bits_available);
+        r->byte_index++;
+        r->bits_available += 8;
+    }
+}
 
-    data <<= r->bit_index;
+uint16_t reader_next(struct reader *r, uint8_t bits_count)
+{
+    if (r->bits_available < bits_count)
+    {
+        reader_refill(r);
+    }
 
-    uint16_t result = (data >> (32 - bits_count));
+    uint16_t result = r->buffer >> (64 - bits_count);
 
-    uint8_t advanced_bit_index = r->bit_index + bits_count;
-    r->bit_index = advanced_bit_index % 8;
-    r->byte_index += advanced_bit_index / 8;
+    r->buffer <<= bits_count;
+    r->bits_available -= bits_count;
 
     return result;
 }
 
-bool reader_has_next(struct reader const *r, uint8_t bits_count)
+bool reader_has_next(struct reader *r, uint8_t bits_count)
 {
-    return r->byte_index + (r->bit_index + bits_count + 7) / 8 <= r->size;
+    if (r->bits_available < bits_count)
+    {
+        reader_refill(r);
+    }
+
+    return r->bits_available >= bits_count;
 }
@@ -4,14 +4,18 @@
 #include <stddef.h>
 #include <stdint.h>
 
+// MSB-first bit reader. Up to 64 bits are kept left-aligned in buffer and
+// refilled from data[byte_index] only when fewer than the requested bits are
+// left, so a refill serves about four 12-bit codes.
 struct reader
 {
     uint8_t const *data;
     size_t size;
     size_t byte_index;
-    uint8_t bit_index;
+    uint64_t buffer;
+    uint8_t bits_available;
 } __attribute__((packed));
 
 extern void reader_init(struct reader *r, uint8_t const *data, size_t size);
 extern uint16_t reader_next(struct reader *r, uint8_t bits_count);
-extern bool reader_has_next(struct reader const *r, uint8_t bits_count);
+extern bool reader_has_next(struct reader *r, uint8_t bits_count);
@@ -0,0 +1,25 @@
+#include "stats.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+_Thread_local struct lzw_stats lzw_stats;
+
+void lzw_stats_reset(void)
+{
+    memset(&lzw_stats, 0, sizeof(lzw_stats));
+}
+
+void lzw_stats_print(FILE *f, const char *label, const struct lzw_stats *s)
+{
+    double sampled = s->sampled_codes > 0 ? (double)s->sampled_codes : 1.0;
+
+    fprintf(f,
+            "stats %-20s: %llu codes, %llu clears, %llu KwKwK, %llu width changes, string length %.2f avg %llu "
+            "max, cycles per code read %.1f table %.1f write %.1f\n",
+            label, (unsigned long long)s->codes, (unsigned long long)s->clears, (unsigned long long)s->kwkwk,
+            (unsigned long long)s->width_changes, s->strings > 0 ? (double)s->string_bytes / s->strings : 0.0,
+            (unsigned long long)s->max_string_length, s->read_cycles / sampled, s->table_cycles / sampled,
+            s->write_cycles / sampled);
+}
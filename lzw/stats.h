@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Counters of lzw_decode_checked and the context kernels behind lzw_decode,
+// collected when built with -DLZW_STATS. They accumulate per thread until
+// lzw_stats_reset. Phase cycles are rdtsc deltas
+// of every LZW_STATS_SAMPLE-th code only, so timing does not slow every code;
+// they include the cost of rdtsc itself. Every code can be sampled and counts
+// toward the phases it went through: a CLEAR_CODE its reset as table time,
+// END_OF_INFORMATION and an invalid code only their read.
+struct lzw_stats
+{
+    uint64_t codes;
+    uint64_t clears;
+    uint64_t kwkwk; // code == next_code, not in the table yet
+    uint64_t strings;
+    uint64_t string_bytes;
+    uint64_t max_string_length;
+    uint64_t width_changes;
+    uint64_t sampled_codes;
+    uint64_t read_cycles;
+    uint64_t table_cycles;
+    uint64_t write_cycles;
+};
+
+#define LZW_STATS_SAMPLE 64
+
+extern _Thread_local struct lzw_stats lzw_stats;
+
+void lzw_stats_reset(void);
+
+// One line: counts, average string length and cycles per code per phase.
+void lzw_stats_print(FILE *f, const char *label, const struct lzw_stats *s);
+
+// LZW_STAT(statements) is compiled in only with -DLZW_STATS, so a default
+// build has no trace of the counters.
+#ifdef LZW_STATS
+#include <stdbool.h>
+#include <x86intrin.h>
+
+#define LZW_STAT(...) __VA_ARGS__
+#define LZW_STAT_CYCLES(sample) ((sample) ? __rdtsc() : 0)
+
+static inline void lzw_stats_string(uint64_t length)
+{
+    lzw_stats.strings++;
+    lzw_stats.string_bytes += length;
+    lzw_stats.max_string_length = length > lzw_stats.max_string_length ? length : lzw_stats.max_string_length;
+}
+
+// Timestamps of one code: before reading it, after reading it, after the
+// table lookup, after writing its string and after the table update.
+static inline void lzw_stats_sample(bool sample, uint64_t start, uint64_t read, uint64_t looked_up, uint64_t written,
+                                    uint64_t end)
+{
+    if (sample)
+    {
+        lzw_stats.sampled_codes++;
+        lzw_stats.read_cycles += read - start;
+        lzw_stats.table_cycles += (looked_up - read) + (end - written);
+        lzw_stats.write_cycles += written - looked_up;
+    }
+}
+#else
+#define LZW_STAT(...)
+#endif
@@ -0,0 +1,140 @@
+#include "stream.h"
+
+#include "common.h"
+#include "decode_table.h"
+#include "reader.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+void lzw_stream_init(struct lzw_stream *s)
+{
+    decode_table_init(&s->table);
+    reader_init(&s->reader, NULL, 0);
+    code_state_clear(&s->state);
+    s->previous_code = CLEAR_CODE;
+    s->finished = false;
+    s->pending_offset = 0;
+    s->pending_length = 0;
+}
+
+// Points the reader at the next chunk, keeping the bits it already buffered.
+static void stream_set_input(struct lzw_stream *s, const uint8_t *in, size_t in_size)
+{
+    uint8_t bits_available = s->reader.bits_available;
+    if (bits_available < 64)
+    {
+        // Below bits_available the buffer may hold bytes of the previous chunk
+        // that were loaded ahead; they are loaded again from the new one.
+        s->reader.buffer &= ~(UINT64_MAX >> bits_available);
+    }
+
+    s->reader.data = in;
+    s->reader.size = in_size;
+    s->reader.byte_index = 0;
+}
+
+static size_t stream_flush(struct lzw_stream *s, uint8_t *w, uint8_t *out_end)
+{
+    size_t count = s->pending_length - s->pending_offset;
+    if (count > (size_t)(out_end - w))
+    {
+        count = out_end - w;
+    }
+
+    memcpy(w, s->pending + s->pending_offset, count);
+    s->pending_offset += count;
+
+    if (s->pending_offset == s->pending_length)
+    {
+        s->pending_offset = 0;
+        s->pending_length = 0;
+    }
+
+    return count;
+}
+
+static size_t stream_decode(struct lzw_stream *s, uint8_t *out, size_t out_size)
+{
+    uint8_t *w = out;
+    uint8_t *out_end = out + out_size;
+
+    w += stream_flush(s, w, out_end);
+
+    while (!s->finished && w < out_end && reader_has_next(&s->reader, s->state.bits_count))
+    {
+        uint16_t code = reader_next(&s->reader, s->state.bits_count);
+
+        enum code_kind kind = code_state_classify(&s->state, code);
+        if (kind == CODE_CLEAR)
+        {
+            decode_table_reset(&s->table);
+            code_state_clear(&s->state);
+            continue;
+        }
+        else if (kind == CODE_END)
+        {
+            s->finished = true;
+            break;
+        }
+        else if (kind == CODE_INVALID)
+        {
+            return -1;
+        }
+
+        bool contains = kind != CODE_KWKWK;
+        uint16_t handled_code = contains ? code : s->previous_code;
+        uint16_t length = decode_table_get_length(&s->table, handled_code) + !contains;
+        uint8_t append_byte = decode_table_get_first_byte(&s->table, handled_code);
+
+        // Strings that do not fit the window are decoded into pending.
+        uint8_t *target = length <= out_end - w ? w : s->pending;
+
+        decode_table_write_bytes(target, handled_code, &s->table);
+
+        if (!contains)
+        {
+            target[length - 1] = append_byte;
+        }
+
+        if (target == w)
+        {
+            w += length;
+        }
+        else
+        {
+            s->pending_length = length;
+            w += stream_flush(s, w, out_end);
+        }
+
+        if (code_state_advance(&s->state) != 0)
+        {
+            decode_table_append(&s->table, s->previous_code, append_byte);
+        }
+
+        s->previous_code = code;
+    }
+
+    return w - out;
+}
+
+size_t lzw_stream_feed(struct lzw_stream *s, const uint8_t *in, size_t in_size, size_t *in_used, uint8_t *out,
+                       size_t out_size)
+{
+    stream_set_input(s, in, in_size);
+
+    size_t written = stream_decode(s, out, out_size);
+
+    *in_used = s->finished ? in_size : s->reader.byte_index;
+
+    return written;
+}
+
+size_t lzw_stream_finish(struct lzw_stream *s, uint8_t *out, size_t out_size)
+{
+    stream_set_input(s, NULL, 0);
+
+    return stream_decode(s, out, out_size);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "code_state.h"
+#include "decode_table.h"
+#include "reader.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Incremental decoder: input arrives in chunks of any size and output goes to
+// windows of any size. Codes split across chunks stay in the reader's bit
+// buffer and strings that do not fit the window wait in pending, so memory
+// use does not depend on the stream length.
+struct lzw_stream
+{
+    struct decode_table table;
+    struct reader reader;
+    struct code_state state;
+    uint16_t previous_code;
+    bool finished;
+    uint16_t pending_offset;
+    uint16_t pending_length;
+    uint8_t pending[MAX_CODE];
+};
+
+void lzw_stream_init(struct lzw_stream *s);
+
+// Decodes from in into out until out is full or all of in is used. Returns the
+// number of bytes written to out or -1 on error; *in_used is set to the number
+// of input bytes taken, the next call must continue from in + *in_used.
+size_t lzw_stream_feed(struct lzw_stream *s, const uint8_t *in, size_t in_size, size_t *in_used, uint8_t *out,
+                       size_t out_size);
+
+// Drains what is left after the last chunk. Returns the number of bytes written
+// to out or -1 on error; the stream is complete once it returns less than
+// out_size.
+size_t lzw_stream_finish(struct lzw_stream *s, uint8_t *out, size_t out_size);
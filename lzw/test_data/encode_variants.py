@@ -0,0 +1,126 @@
+# Generates the test vectors of the GIF, PDF and compress variants, which
+# imagecodecs does not write. The decoder appends after every code but the
+# first after CLEAR and widens codes once next_code + early_change reaches
+# 1 << width; the encoder, one entry ahead, follows the same schedule.
+# compress output can be checked with gzip -dc.
+import random
+
+
+class BitWriter:
+    def __init__(self, msb_first):
+        self.msb_first = msb_first
+        self.buffer = 0
+        self.bits = 0
+        self.out = bytearray()
+
+    def put(self, code, width):
+        if self.msb_first:
+            self.buffer = (self.buffer << width) | code
+            self.bits += width
+            while self.bits >= 8:
+                self.bits -= 8
+                self.out.append((self.buffer >> self.bits) & 0xFF)
+        else:
+            self.buffer |= code << self.bits
+            self.bits += width
+            while self.bits >= 8:
+                self.out.append(self.buffer & 0xFF)
+                self.buffer >>= 8
+                self.bits -= 8
+
+    def finish(self):
+        if self.bits:
+            self.out.append(((self.buffer << (8 - self.bits)) if self.msb_first else self.buffer) & 0xFF)
+        return bytes(self.out)
+
+
+def encode(data, msb_first, root_bits, max_bits, early_change, has_clear=True, has_end=True,
+           initial_clear=True, clear_at=None, group_padding=False):
+    clear_code = 1 << root_bits
+    end_code = clear_code + 1
+    first_code = clear_code + has_clear + has_end
+    table_size = 1 << max_bits
+    clear_at = clear_at or table_size
+
+    writer = BitWriter(msb_first)
+    state = {'width': root_bits + 1, 'next': first_code, 'codes': 0, 'table': {}}
+
+    def emit(code):
+        writer.put(code, state['width'])
+        state['codes'] += 1
+
+    def pad():
+        # compress reads codes in groups of 8 and drops the rest of a group
+        # whenever the width changes
+        if group_padding:
+            for _ in range(-state['codes'] % 8):
+                writer.put(0, state['width'])
+        state['codes'] = 0
+
+    def clear():
+        emit(clear_code)
+        pad()
+        state.update(width=root_bits + 1, next=first_code, table={})
+
+    if has_clear and initial_clear:
+        clear()
+
+    if data:
+        prefix = data[0]
+        i = 1
+        while True:
+            last = i == len(data)
+            if not last:
+                byte = data[i]
+                i += 1
+                if (prefix, byte) in state['table']:
+                    prefix = state['table'][(prefix, byte)]
+                    continue
+
+            emit(prefix)
+            if state['next'] < table_size:
+                if not last:
+                    state['table'][(prefix, byte)] = state['next']
+                state['next'] += 1
+                decoder_next = state['next'] - 1
+                if decoder_next + early_change == 1 << state['width'] and state['width'] < max_bits:
+                    pad()
+                    state['width'] += 1
+                if has_clear and state['next'] >= clear_at:
+                    clear()
+
+            if last:
+                break
+            prefix = byte
+
+    if has_end:
+        emit(end_code)
+    return writer.finish()
+
+
+def compress(data, max_bits, block_mode=True, clear_at=None):
+    header = bytes([0x1F, 0x9D, max_bits | (0x80 if block_mode else 0)])
+    return header + encode(data, False, 8, max_bits, 0, has_clear=block_mode, has_end=False, initial_clear=False,
+                           clear_at=clear_at, group_padding=True)
+
+
+with open('out', 'rb') as f:
+    out = f.read()
+
+random.seed(14)
+gif_2 = bytes(random.choice([0, 1, 2, 3]) if random.random() < 0.3 else 1 for _ in range(20000))
+
+vectors = {
+    'gif_2.dec': gif_2,
+    'gif_2.enc': encode(gif_2, False, 2, 12, 0),
+    'out.gif': encode(out, False, 8, 12, 0),
+    'out_deferred.gif': encode(out, False, 8, 12, 0, clear_at=1 << 20),  # table stays full, no CLEAR
+    'out_early0.pdf': encode(out, True, 8, 12, 0, clear_at=4095),
+    'out.Z': compress(out, 16),
+    'out_12.Z': compress(out, 12, clear_at=1000),
+    'out_nonblock.Z': compress(out, 12, block_mode=False),
+}
+
+for name, data in vectors.items():
+    with open(name, 'wb') as f:
+        f.write(data)
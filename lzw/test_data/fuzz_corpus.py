@@ -0,0 +1,31 @@
+# Seed corpus for fuzz.c from the TIFF test vectors: each stream decoded into
+# its exact size and one byte short, and each plaintext as a round trip.
+# Usage: python3 fuzz_corpus.py [output directory, default fuzz]
+import os, sys
+
+FUZZ_DECODE, FUZZ_ROUND_TRIP = 0, 1
+PAIRS = [('in', 'out'), ('aaa.enc', 'aaa.dec'), ('10_1.enc', '10_1.dec'), ('100_1.enc', '100_1.dec'),
+         ('100_2.enc', '100_2.dec'), ('1000.enc', '1000.dec')]
+
+here = os.path.dirname(os.path.abspath(__file__))
+out_dir = sys.argv[1] if len(sys.argv) > 1 else os.path.join(here, 'fuzz')
+os.makedirs(out_dir, exist_ok=True)
+
+def write(name, data):
+    with open(os.path.join(out_dir, name), 'wb') as f:
+        f.write(data)
+
+for encoded_name, decoded_name in PAIRS:
+    with open(os.path.join(here, encoded_name), 'rb') as f:
+        encoded = f.read()
+    with open(os.path.join(here, decoded_name), 'rb') as f:
+        decoded = f.read()
+    stem = encoded_name.split('.')[0]
+    for suffix, size in (('exact', len(decoded)), ('short', len(decoded) - 1)):
+        write(f'decode_{stem}_{suffix}', bytes([FUZZ_DECODE]) + size.to_bytes(2, 'big') + encoded)
+    write(f'round_trip_{stem}', bytes([FUZZ_ROUND_TRIP]) + decoded[:4096])
+
+# PDF streams switch width one code later, which TIFF decoders must reject or
+# decode the same way
+with open(os.path.join(here, 'out_early0.pdf'), 'rb') as f:
+    write('decode_early0', bytes([FUZZ_DECODE]) + (30000).to_bytes(2, 'big') + f.read())
@@ -0,0 +1,405 @@
+#define _POSIX_C_SOURCE 200809L
+#include "tiff.h"
+
+#include "common.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TAG_IMAGE_WIDTH 256
+#define TAG_IMAGE_LENGTH 257
+#define TAG_BITS_PER_SAMPLE 258
+#define TAG_COMPRESSION 259
+#define TAG_STRIP_OFFSETS 273
+#define TAG_SAMPLES_PER_PIXEL 277
+#define TAG_ROWS_PER_STRIP 278
+#define TAG_STRIP_BYTE_COUNTS 279
+#define TAG_PLANAR_CONFIGURATION 284
+#define TAG_PREDICTOR 317
+#define TAG_TILE_WIDTH 322
+#define TAG_TILE_LENGTH 323
+#define TAG_TILE_OFFSETS 324
+#define TAG_TILE_BYTE_COUNTS 325
+
+// A tag's values: count values of size bytes each, starting at offset in the
+// file. size is 0 for types that carry no integers.
+struct tiff_entry
+{
+    uint64_t offset;
+    uint64_t count;
+    uint8_t size;
+};
+
+static bool tiff_in_file(const struct tiff_file *f, uint64_t offset, uint64_t size)
+{
+    return offset <= f->size && size <= f->size - offset;
+}
+
+static uint64_t tiff_get(const struct tiff_file *f, uint64_t offset, unsigned size)
+{
+    uint64_t value = 0;
+    for (unsigned i = 0; i < size; i++)
+    {
+        unsigned shift = f->big_endian ? (size - 1 - i) * 8 : i * 8;
+        value |= (uint64_t)f->data[offset + i] << shift;
+    }
+
+    return value;
+}
+
+static uint8_t tiff_type_size(uint16_t type)
+{
+    switch (type)
+    {
+    case 1: // BYTE
+        return 1;
+    case 3: // SHORT
+        return 2;
+    case 4:  // LONG
+    case 13: // IFD
+        return 4;
+    case 16: // LONG8
+    case 18: // IFD8
+        return 8;
+    }
+    return 0;
+}
+
+static uint64_t tiff_value(const struct tiff_file *f, const struct tiff_entry *e, uint64_t index)
+{
+    return tiff_get(f, e->offset + index * e->size, e->size);
+}
+
+// Reads the first value of a single-valued tag if it is present.
+static bool tiff_scalar(const struct tiff_file *f, const struct tiff_entry *e, uint64_t *value)
+{
+    if (e->count == 0)
+    {
+        return true;
+    }
+    if (e->size == 0)
+    {
+        return false;
+    }
+
+    *value = tiff_value(f, e, 0);
+    return true;
+}
+
+int16_t tiff_open_memory(struct tiff_file *f, const uint8_t *data, size_t size)
+{
+    *f = (struct tiff_file){data, size, false, false, false, 0};
+
+    if (data == NULL || size < 8)
+    {
+        return INVALID_TIFF;
+    }
+
+    if (data[0] == 'I' && data[1] == 'I')
+    {
+        f->big_endian = false;
+    }
+    else if (data[0] == 'M' && data[1] == 'M')
+    {
+        f->big_endian = true;
+    }
+    else
+    {
+        return INVALID_TIFF;
+    }
+
+    uint64_t magic = tiff_get(f, 2, 2);
+    if (magic == 42)
+    {
+        f->first_ifd = tiff_get(f, 4, 4);
+    }
+    else if (magic == 43 && size >= 16 && tiff_get(f, 4, 2) == 8 && tiff_get(f, 6, 2) == 0)
+    {
+        f->big_tiff = true;
+        f->first_ifd = tiff_get(f, 8, 8);
+    }
+    else
+    {
+        return INVALID_TIFF;
+    }
+
+    return SUCCESS;
+}
+
+int16_t tiff_open(struct tiff_file *f, const char *path)
+{
+    *f = (struct tiff_file){NULL, 0, false, false, false, 0};
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return INVALID_TIFF;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || (uint64_t)st.st_size > SIZE_MAX)
+    {
+        close(fd);
+        return INVALID_TIFF;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return INVALID_TIFF;
+    }
+
+    int16_t result = tiff_open_memory(f, data, size);
+    if (result != SUCCESS)
+    {
+        munmap(data, size);
+        *f = (struct tiff_file){NULL, 0, false, false, false, 0};
+        return result;
+    }
+
+    f->mapped = true;
+    return SUCCESS;
+}
+
+void tiff_close(struct tiff_file *f)
+{
+    if (f->mapped)
+    {
+        munmap((void *)f->data, f->size);
+    }
+    *f = (struct tiff_file){NULL, 0, false, false, false, 0};
+}
+
+void tiff_image_free(struct tiff_image *image)
+{
+    free(image->segments);
+    image->segments = NULL;
+    image->segment_count = 0;
+}
+
+static int16_t tiff_segments(const struct tiff_file *f, struct tiff_image *image, const struct tiff_entry *offsets,
+                             const struct tiff_entry *byte_counts, uint64_t rows_per_strip)
+{
+    uint64_t planes = image->planar_configuration == 2 ? image->samples_per_pixel : 1;
+    uint64_t samples = image->planar_configuration == 2 ? 1 : image->samples_per_pixel;
+    uint64_t per_plane;
+
+    if (image->tiled)
+    {
+        uint64_t across = ((uint64_t)image->width + image->segment_width - 1) / image->segment_width;
+        uint64_t down = ((uint64_t)image->height + image->segment_height - 1) / image->segment_height;
+        per_plane = across * down;
+    }
+    else
+    {
+        per_plane = ((uint64_t)image->height + rows_per_strip - 1) / rows_per_strip;
+    }
+
+    // Each segment needs its own offset in the file, which bounds the count
+    // before anything is allocated.
+    if (offsets->size == 0 || byte_counts->size == 0 || offsets->count != per_plane * planes ||
+        byte_counts->count != offsets->count || offsets->count > f->size)
+    {
+        return INVALID_TIFF;
+    }
+
+    uint64_t row_size = ((uint64_t)image->segment_width * samples * image->bits_per_sample + 7) / 8;
+
+    image->segment_count = (size_t)offsets->count;
+    image->segments = malloc((image->segment_count > 0 ? image->segment_count : 1) * sizeof(*image->segments));
+    if (image->segments == NULL)
+    {
+        return INVALID_TIFF;
+    }
+
+    for (size_t i = 0; i < image->segment_count; i++)
+    {
+        uint64_t offset = tiff_value(f, offsets, i);
+        uint64_t size = tiff_value(f, byte_counts, i);
+        if (!tiff_in_file(f, offset, size))
+        {
+            tiff_image_free(image);
+            return INVALID_TIFF;
+        }
+
+        uint64_t rows = image->segment_height;
+        if (!image->tiled)
+        {
+            uint64_t first_row = (i % per_plane) * rows_per_strip;
+            rows = image->height - first_row < rows_per_strip ? image->height - first_row : rows_per_strip;
+        }
+
+        uint64_t decoded_size = rows * row_size;
+        if (decoded_size > SIZE_MAX)
+        {
+            tiff_image_free(image);
+            return INVALID_TIFF;
+        }
+
+        image->segments[i] = (struct tiff_segment){f->data + offset, (size_t)size, (size_t)decoded_size};
+    }
+
+    return SUCCESS;
+}
+
+int16_t tiff_read_ifd(const struct tiff_file *f, uint64_t *ifd, struct tiff_image *image)
+{
+    *image = (struct tiff_image){0};
+
+    unsigned count_size = f->big_tiff ? 8 : 2;
+    unsigned entry_size = f->big_tiff ? 20 : 12;
+    unsigned offset_size = f->big_tiff ? 8 : 4;
+
+    if (*ifd == 0 || !tiff_in_file(f, *ifd, count_size))
+    {
+        return INVALID_TIFF;
+    }
+
+    uint64_t entry_count = tiff_get(f, *ifd, count_size);
+    uint64_t entries = *ifd + count_size;
+    if (entry_count > f->size / entry_size || !tiff_in_file(f, entries, entry_count * entry_size + offset_size))
+    {
+        return INVALID_TIFF;
+    }
+
+    struct tiff_entry width = {0}, height = {0}, bits_per_sample = {0}, compression = {0}, samples_per_pixel = {0},
+                      rows_per_strip = {0}, planar_configuration = {0}, predictor = {0}, tile_width = {0},
+                      tile_length = {0}, strip_offsets = {0}, strip_byte_counts = {0}, tile_offsets = {0},
+                      tile_byte_counts = {0};
+
+    for (uint64_t i = 0; i < entry_count; i++)
+    {
+        uint64_t entry = entries + i * entry_size;
+        uint16_t tag = tiff_get(f, entry, 2);
+        uint8_t size = tiff_type_size(tiff_get(f, entry + 2, 2));
+        uint64_t count = tiff_get(f, entry + 4, offset_size);
+        uint64_t value = entry + 4 + offset_size;
+
+        if (size != 0 && count > f->size / size)
+        {
+            return INVALID_TIFF;
+        }
+        if (count * size > offset_size)
+        {
+            value = tiff_get(f, value, offset_size);
+            if (!tiff_in_file(f, value, count * size))
+            {
+                return INVALID_TIFF;
+            }
+        }
+
+        struct tiff_entry e = {value, count, size};
+        switch (tag)
+        {
+        case TAG_IMAGE_WIDTH:
+            width = e;
+            break;
+        case TAG_IMAGE_LENGTH:
+            height = e;
+            break;
+        case TAG_BITS_PER_SAMPLE:
+            bits_per_sample = e;
+            break;
+        case TAG_COMPRESSION:
+            compression = e;
+            break;
+        case TAG_STRIP_OFFSETS:
+            strip_offsets = e;
+            break;
+        case TAG_SAMPLES_PER_PIXEL:
+            samples_per_pixel = e;
+            break;
+        case TAG_ROWS_PER_STRIP:
+            rows_per_strip = e;
+            break;
+        case TAG_STRIP_BYTE_COUNTS:
+            strip_byte_counts = e;
+            break;
+        case TAG_PLANAR_CONFIGURATION:
+            planar_configuration = e;
+            break;
+        case TAG_PREDICTOR:
+            predictor = e;
+            break;
+        case TAG_TILE_WIDTH:
+            tile_width = e;
+            break;
+        case TAG_TILE_LENGTH:
+            tile_length = e;
+            break;
+        case TAG_TILE_OFFSETS:
+            tile_offsets = e;
+            break;
+        case TAG_TILE_BYTE_COUNTS:
+            tile_byte_counts = e;
+            break;
+        }
+    }
+
+    uint64_t v_width = 0, v_height = 0, v_bits = 1, v_compression = 1, v_samples = 1, v_rows = UINT32_MAX,
+             v_planar = 1, v_predictor = 1, v_tile_width = 0, v_tile_length = 0;
+
+    if (!tiff_scalar(f, &width, &v_width) || !tiff_scalar(f, &height, &v_height) ||
+        !tiff_scalar(f, &bits_per_sample, &v_bits) || !tiff_scalar(f, &compression, &v_compression) ||
+        !tiff_scalar(f, &samples_per_pixel, &v_samples) || !tiff_scalar(f, &rows_per_strip, &v_rows) ||
+        !tiff_scalar(f, &planar_configuration, &v_planar) || !tiff_scalar(f, &predictor, &v_predictor) ||
+        !tiff_scalar(f, &tile_width, &v_tile_width) || !tiff_scalar(f, &tile_length, &v_tile_length))
+    {
+        return INVALID_TIFF;
+    }
+
+    if (v_width == 0 || v_width > UINT32_MAX || v_height == 0 || v_height > UINT32_MAX || v_bits == 0 ||
+        v_bits > 64 || v_samples == 0 || v_samples > UINT16_MAX || v_compression > UINT16_MAX ||
+        v_predictor > UINT16_MAX || (v_planar != 1 && v_planar != 2) || v_rows == 0 || v_tile_width > UINT32_MAX ||
+        v_tile_length > UINT32_MAX)
+    {
+        return INVALID_TIFF;
+    }
+
+    image->width = (uint32_t)v_width;
+    image->height = (uint32_t)v_height;
+    image->bits_per_sample = (uint16_t)v_bits;
+    image->samples_per_pixel = (uint16_t)v_samples;
+    image->compression = (uint16_t)v_compression;
+    image->predictor = (uint16_t)v_predictor;
+    image->planar_configuration = (uint16_t)v_planar;
+    image->tiled = tile_offsets.count != 0;
+
+    int16_t result;
+    if (image->tiled)
+    {
+        if (v_tile_width == 0 || v_tile_length == 0)
+        {
+            return INVALID_TIFF;
+        }
+        image->segment_width = (uint32_t)v_tile_width;
+        image->segment_height = (uint32_t)v_tile_length;
+        result = tiff_segments(f, image, &tile_offsets, &tile_byte_counts, 0);
+    }
+    else
+    {
+        if (v_rows > v_height)
+        {
+            v_rows = v_height;
+        }
+        image->segment_width = image->width;
+        image->segment_height = (uint32_t)v_rows;
+        result = tiff_segments(f, image, &strip_offsets, &strip_byte_counts, v_rows);
+    }
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    *ifd = tiff_get(f, entries + entry_count * entry_size, offset_size);
+    return SUCCESS;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TIFF_COMPRESSION_LZW 5
+
+// A TIFF file mapped into memory, classic or BigTIFF, in either byte order.
+struct tiff_file
+{
+    const uint8_t *data;
+    size_t size;
+    bool big_endian;
+    bool big_tiff;
+    bool mapped;
+    uint64_t first_ifd;
+};
+
+// One strip or tile: data points into the file, decoded_size is the size of
+// the uncompressed segment.
+struct tiff_segment
+{
+    const uint8_t *data;
+    size_t size;
+    size_t decoded_size;
+};
+
+struct tiff_image
+{
+    uint32_t width;
+    uint32_t height;
+    uint16_t bits_per_sample;
+    uint16_t samples_per_pixel;
+    uint16_t compression;
+    uint16_t predictor;
+    uint16_t planar_configuration;
+    bool tiled;
+    uint32_t segment_width;
+    uint32_t segment_height;
+    size_t segment_count;
+    struct tiff_segment *segments;
+};
+
+// Maps path read-only. Returns SUCCESS or INVALID_TIFF.
+int16_t tiff_open(struct tiff_file *f, const char *path);
+
+// Same over a buffer the caller keeps alive.
+int16_t tiff_open_memory(struct tiff_file *f, const uint8_t *data, size_t size);
+
+void tiff_close(struct tiff_file *f);
+
+// Parses the IFD at *ifd, starting with f->first_ifd, and moves *ifd to the
+// next one, 0 after the last. Every segment is checked to lie inside the file.
+// Returns SUCCESS or INVALID_TIFF; on success release with tiff_image_free.
+int16_t tiff_read_ifd(const struct tiff_file *f, uint64_t *ifd, struct tiff_image *image);
+
+void tiff_image_free(struct tiff_image *image);
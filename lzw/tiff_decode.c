@@ -0,0 +1,139 @@
+#define _POSIX_C_SOURCE 200809L
+#include "batch.h"
+#include "common.h"
+#include "decode.h"
+#include "tiff.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Cyclic IFD chains would otherwise loop forever.
+#define MAX_IMAGES 65536
+
+static inline double get_time_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// Decodes every LZW strip or tile of one image straight from the mapping with
+// lzw_decode_copy, which bounds-checks untrusted files.
+static int decode_image(size_t index, const struct tiff_image *image, unsigned threads, int iterations)
+{
+    printf("image %zu: %ux%u, %u x %u-bit samples, %zu %s\n", index, image->width, image->height,
+           image->samples_per_pixel, image->bits_per_sample, image->segment_count,
+           image->tiled ? "tiles" : "strips");
+
+    if (image->compression != TIFF_COMPRESSION_LZW)
+    {
+        printf("  compression %u, skipped\n", image->compression);
+        return 0;
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < image->segment_count; i++)
+    {
+        total += image->segments[i].decoded_size;
+    }
+
+    struct lzw_job *jobs = malloc((image->segment_count > 0 ? image->segment_count : 1) * sizeof(*jobs));
+    uint8_t *out = malloc(total > 0 ? total : 1);
+    if (jobs == NULL || out == NULL)
+    {
+        printf("  memory allocation failed\n");
+        free(jobs);
+        free(out);
+        return 1;
+    }
+
+    size_t offset = 0;
+    for (size_t i = 0; i < image->segment_count; i++)
+    {
+        const struct tiff_segment *segment = &image->segments[i];
+        jobs[i] = (struct lzw_job){segment->data, segment->size, out + offset, segment->decoded_size, 0, SUCCESS};
+        offset += segment->decoded_size;
+    }
+
+    size_t failed = lzw_decode_batch(jobs, image->segment_count, lzw_decode_copy, threads);
+
+    double total_time = 0;
+    for (int i = 0; i < iterations; i++)
+    {
+        double start = get_time_ms();
+        lzw_decode_batch(jobs, image->segment_count, lzw_decode_copy, threads);
+        total_time += get_time_ms() - start;
+    }
+
+    size_t decoded = 0;
+    int16_t first_error = SUCCESS;
+    for (size_t i = 0; i < image->segment_count; i++)
+    {
+        if (jobs[i].result != (size_t)-1)
+        {
+            decoded += jobs[i].result;
+        }
+        else if (first_error == SUCCESS)
+        {
+            first_error = jobs[i].error;
+        }
+    }
+
+    double avg_time = total_time / iterations;
+    printf("  %zu of %zu bytes decoded, %zu failed, %.3f ms (%.1f MB/s)\n", decoded, total, failed, avg_time,
+           decoded / (avg_time / 1000.0) / (1024.0 * 1024.0));
+    if (first_error != SUCCESS)
+    {
+        printf("  first failure: %s\n", error_message(first_error));
+    }
+
+    free(jobs);
+    free(out);
+    return failed != 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 4)
+    {
+        fprintf(stderr, "usage: %s file.tif [threads] [iterations]\n", argv[0]);
+        return 2;
+    }
+
+    unsigned threads = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : 0;
+    int iterations = argc > 3 ? atoi(argv[3]) : 10;
+    if (iterations <= 0)
+    {
+        iterations = 1;
+    }
+
+    struct tiff_file f;
+    int16_t result = tiff_open(&f, argv[1]);
+    if (result != SUCCESS)
+    {
+        fprintf(stderr, "%s: %s\n", argv[1], error_message(result));
+        return 1;
+    }
+
+    int failed = 0;
+    uint64_t ifd = f.first_ifd;
+    for (size_t index = 0; ifd != 0 && index < MAX_IMAGES; index++)
+    {
+        struct tiff_image image;
+        result = tiff_read_ifd(&f, &ifd, &image);
+        if (result != SUCCESS)
+        {
+            fprintf(stderr, "%s: image %zu: %s\n", argv[1], index, error_message(result));
+            failed = 1;
+            break;
+        }
+
+        failed |= decode_image(index, &image, threads, iterations);
+        tiff_image_free(&image);
+    }
+
+    tiff_close(&f);
+    return failed;
+}
@@ -0,0 +1,183 @@
+#include "../minunit/minunit.h"
+
+#include "lzw.hpp"
+#include "read_file.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using decode_fn = size_t (*)(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size);
+
+static void test_base(decode_fn decode, const std::vector<uint8_t> &encoded, const std::vector<uint8_t> &expected)
+{
+    mu_assert(!encoded.empty() && !expected.empty(), "failed to read test data");
+
+    std::vector<uint8_t> decoded(expected.size());
+    size_t decoded_size = decode(encoded.data(), encoded.size(), decoded.data(), decoded.size());
+    mu_assert(decoded_size == expected.size(), "decoded size mismatch");
+    mu_assert(decoded == expected, "decoded content does not match expected");
+
+    // One byte short of the output must fail, not write past it
+    if (expected.size() > 1)
+    {
+        decoded_size = decode(encoded.data(), encoded.size(), decoded.data(), expected.size() - 1);
+        mu_assert(decoded_size == static_cast<size_t>(-1), "too small output should fail");
+    }
+}
+
+static void test_files(decode_fn decode, const char *encoded_path, const char *expected_path)
+{
+    test_base(decode, read_file(encoded_path), read_file(expected_path));
+}
+
+// The runtime dispatch of decode_pdf and decode_gif
+static size_t decode_pdf_early_change(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size)
+{
+    return lzw::decode_pdf(true, in, in_size, out, out_size);
+}
+
+static size_t decode_gif_2(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size)
+{
+    return lzw::decode_gif(2, in, in_size, out, out_size);
+}
+
+MU_TEST(test_tiff_in_out)
+{
+    test_files(lzw::decode<lzw::tiff>, "test_data/in", "test_data/out");
+}
+
+MU_TEST(test_tiff_1000)
+{
+    test_files(lzw::decode<lzw::tiff>, "test_data/1000.enc", "test_data/1000.dec");
+}
+
+MU_TEST(test_tiff_aaa)
+{
+    test_files(lzw::decode<lzw::tiff>, "test_data/aaa.enc", "test_data/aaa.dec");
+}
+
+MU_TEST(test_pdf_early_change)
+{
+    // Example from the PDF reference, section LZWDecode and LZWEncode Filters
+    test_base(decode_pdf_early_change, {0x80, 0x0b, 0x60, 0x50, 0x22, 0x0c, 0x0c, 0x85, 0x01},
+              {0x2d, 0x2d, 0x2d, 0x2d, 0x2d, 0x41, 0x2d, 0x2d, 0x2d, 0x42});
+}
+
+MU_TEST(test_pdf_no_early_change)
+{
+    test_files(lzw::decode<lzw::pdf<0>>, "test_data/out_early0.pdf", "test_data/out");
+}
+
+MU_TEST(test_gif_sample)
+{
+    // Raster data of the 10x10 sample image from the GIF89a walkthrough
+    test_base(decode_gif_2,
+              {0x8c, 0x2d, 0x99, 0x87, 0x2a, 0x1c, 0xdc, 0x33, 0xa0, 0x02, 0x75,
+               0xec, 0x95, 0xfa, 0xa8, 0xde, 0x60, 0x8c, 0x04, 0x91, 0x4c, 0x01},
+              {1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2,
+               1, 1, 1, 0, 0, 0, 0, 2, 2, 2, 1, 1, 1, 0, 0, 0, 0, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1, 1,
+               2, 2, 2, 0, 0, 0, 0, 1, 1, 1, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1,
+               2, 2, 2, 2, 2, 1, 1, 1, 1, 1});
+}
+
+MU_TEST(test_gif_2)
+{
+    test_files(lzw::decode<lzw::gif<2>>, "test_data/gif_2.enc", "test_data/gif_2.dec");
+}
+
+MU_TEST(test_gif_8)
+{
+    test_files(lzw::decode<lzw::gif<8>>, "test_data/out.gif", "test_data/out");
+}
+
+MU_TEST(test_gif_deferred_clear)
+{
+    test_files(lzw::decode<lzw::gif<8>>, "test_data/out_deferred.gif", "test_data/out");
+}
+
+MU_TEST(test_compress_16)
+{
+    test_files(lzw::decode_compress, "test_data/out.Z", "test_data/out");
+}
+
+MU_TEST(test_compress_12_clear)
+{
+    test_files(lzw::decode_compress, "test_data/out_12.Z", "test_data/out");
+}
+
+MU_TEST(test_compress_no_block_mode)
+{
+    test_files(lzw::decode_compress, "test_data/out_nonblock.Z", "test_data/out");
+}
+
+MU_TEST(test_invalid)
+{
+    uint8_t out[16];
+
+    // CLEAR, then code 258 while the table is empty
+    const uint8_t tiff_undefined[] = {0x80, 0x40, 0x80};
+    mu_assert(lzw::decode<lzw::tiff>(tiff_undefined, sizeof(tiff_undefined), out, sizeof(out)) ==
+                  static_cast<size_t>(-1),
+              "undefined code should fail");
+
+    // GIF root 2: CLEAR (4), then code 6 before any entry exists
+    const uint8_t gif_undefined[] = {0x34};
+    mu_assert(lzw::decode<lzw::gif<2>>(gif_undefined, sizeof(gif_undefined), out, sizeof(out)) ==
+                  static_cast<size_t>(-1),
+              "undefined code should fail");
+
+    const uint8_t bad_magic[] = {0x1f, 0x8b, 0x90, 0x41};
+    mu_assert(lzw::decode_compress(bad_magic, sizeof(bad_magic), out, sizeof(out)) == static_cast<size_t>(-1),
+              "wrong magic should fail");
+
+    const uint8_t bad_bits[] = {0x1f, 0x9d, 0x91, 0x41};
+    mu_assert(lzw::decode_compress(bad_bits, sizeof(bad_bits), out, sizeof(out)) == static_cast<size_t>(-1),
+              "17-bit codes should fail");
+
+    mu_assert(lzw::decode_gif(9, gif_undefined, sizeof(gif_undefined), out, sizeof(out)) == static_cast<size_t>(-1),
+              "root bits above 8 should fail");
+}
+
+MU_TEST(test_truncated_input)
+{
+    std::vector<uint8_t> encoded = read_file("test_data/out.gif");
+    std::vector<uint8_t> expected = read_file("test_data/out");
+    mu_assert(!encoded.empty() && !expected.empty(), "failed to read test data");
+
+    // Without the END code a cut stream decodes to a prefix of the data
+    std::vector<uint8_t> decoded(expected.size());
+    for (size_t size = 0; size < encoded.size(); size += 97)
+    {
+        size_t decoded_size = lzw::decode<lzw::gif<8>>(encoded.data(), size, decoded.data(), decoded.size());
+        mu_assert(decoded_size <= expected.size(), "truncated input should decode a prefix");
+        mu_assert(std::memcmp(decoded.data(), expected.data(), decoded_size) == 0,
+                  "truncated input should decode a prefix");
+    }
+}
+
+MU_TEST_SUITE(variants_suite)
+{
+    MU_RUN_TEST(test_tiff_in_out);
+    MU_RUN_TEST(test_tiff_1000);
+    MU_RUN_TEST(test_tiff_aaa);
+    MU_RUN_TEST(test_pdf_early_change);
+    MU_RUN_TEST(test_pdf_no_early_change);
+    MU_RUN_TEST(test_gif_sample);
+    MU_RUN_TEST(test_gif_2);
+    MU_RUN_TEST(test_gif_8);
+    MU_RUN_TEST(test_gif_deferred_clear);
+    MU_RUN_TEST(test_compress_16);
+    MU_RUN_TEST(test_compress_12_clear);
+    MU_RUN_TEST(test_compress_no_block_mode);
+    MU_RUN_TEST(test_invalid);
+    MU_RUN_TEST(test_truncated_input);
+}
+
+int main()
+{
+    MU_RUN_SUITE(variants_suite);
+    MU_REPORT();
+    return MU_EXIT_CODE;
+}